@@ -0,0 +1,133 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+// ----> Includes
+#include "imageconversion.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+// <---- Includes
+
+#define BENCH_ITERATIONS 50
+
+// Measure the average conversion throughput of a function in pixels per nanosecond
+template<typename F>
+double benchmark( size_t pixels, F func )
+{
+    func(); // warm up
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( int i=0; i<BENCH_ITERATIONS; i++ )
+        func();
+    double nsec = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now()-start ).count();
+
+    return (pixels*BENCH_ITERATIONS)/nsec;
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    using namespace sl_oc::video;
+
+    const char* resNames[] = {"HD2K", "HD1080", "HD720", "VGA"};
+
+    const COLOR_FORMAT formats[] = {COLOR_FORMAT::BGR, COLOR_FORMAT::RGB, COLOR_FORMAT::BGRA, COLOR_FORMAT::RGBA,
+                                    COLOR_FORMAT::GRAY, COLOR_FORMAT::YUV422P};
+    const char* formatNames[] = {"BGR", "RGB", "BGRA", "RGBA", "GRAY", "YUV422P"};
+    const int cvCodes[] = {cv::COLOR_YUV2BGR_YUYV, cv::COLOR_YUV2RGB_YUYV, cv::COLOR_YUV2BGRA_YUYV, cv::COLOR_YUV2RGBA_YUYV,
+                           cv::COLOR_YUV2GRAY_YUYV, -1};
+
+    const CONVERSION_KERNEL kernels[] = {CONVERSION_KERNEL::SCALAR, CONVERSION_KERNEL::SSE4, CONVERSION_KERNEL::AVX2,
+                                        CONVERSION_KERNEL::NEON};
+    const char* kernelNames[] = {"AUTO", "SCALAR", "SSE4", "AVX2", "NEON"};
+
+    std::cout << "Throughput in pixels/ns, " << BENCH_ITERATIONS << " iterations. 'MT': all the CPU cores" << std::endl;
+
+    for( int r=0; r<static_cast<int>(RESOLUTION::LAST); r++ )
+    {
+        // ----> Side by side YUYV frame of a random image
+        int width = static_cast<int>(cameraResolution[r].width)*2;
+        int height = static_cast<int>(cameraResolution[r].height);
+        size_t pixels = static_cast<size_t>(width)*height;
+
+        cv::Mat frameYUV( height, width, CV_8UC2 );
+        cv::randu( frameYUV, cv::Scalar::all(0), cv::Scalar::all(255) );
+        // <---- Side by side YUYV frame of a random image
+
+        std::cout << std::endl << resNames[r] << " (" << width << "x" << height << ")" << std::endl;
+        std::cout << std::setw(10) << "format" << std::setw(10) << "cvtColor";
+        for( CONVERSION_KERNEL kernel : kernels )
+        {
+            if( setConversionKernel(kernel) )
+            {
+                std::cout << std::setw(10) << kernelNames[static_cast<int>(kernel)]
+                          << std::setw(10) << (std::string(kernelNames[static_cast<int>(kernel)])+" MT");
+            }
+        }
+        std::cout << std::endl;
+
+        for( size_t f=0; f<sizeof(formats)/sizeof(COLOR_FORMAT); f++ )
+        {
+            std::cout << std::setw(10) << formatNames[f] << std::fixed << std::setprecision(3);
+
+            // ----> OpenCV reference
+            if( cvCodes[f]!=-1 )
+            {
+                cv::Mat out;
+                std::cout << std::setw(10) << benchmark( pixels, [&]() {cv::cvtColor(frameYUV,out,cvCodes[f]);} );
+            }
+            else
+            {
+                std::cout << std::setw(10) << "n/a";
+            }
+            // <---- OpenCV reference
+
+            // ----> Library kernels, single thread and multithreaded
+            std::vector<uint8_t> out( getConvertedSize(width,height,formats[f]) );
+            size_t step = static_cast<size_t>(width)*getColorFormatChannels(formats[f]);
+
+            for( CONVERSION_KERNEL kernel : kernels )
+            {
+                if( !setConversionKernel(kernel) )
+                    continue;
+
+                for( int threads : {1,0} )
+                {
+                    std::cout << std::setw(10) << benchmark( pixels, [&]() {
+                        convertYUYV( frameYUV.data, frameYUV.step, out.data(), step, width, height, formats[f], threads );
+                    });
+                }
+            }
+            // <---- Library kernels, single thread and multithreaded
+
+            std::cout << std::endl;
+        }
+    }
+
+    setConversionKernel(CONVERSION_KERNEL::AUTO);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,323 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+// ----> Includes
+#include "rectifier.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+// <---- Includes
+
+#define BENCH_ITERATIONS 50
+#define MAX_REMAP_DIFF 2        // Max difference with cv::remap, the interpolation weights are quantized
+#define MAX_CONVERSION_DIFF 4   // Max difference with cv::cvtColor followed by cv::remap, the conversion rounds too
+
+using namespace sl_oc::video;
+
+// Measure the average rectification throughput of a function in pixels per nanosecond
+template<typename F>
+double benchmark( size_t pixels, F func )
+{
+    func(); // warm up
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( int i=0; i<BENCH_ITERATIONS; i++ )
+        func();
+    double nsec = std::chrono::duration<double,std::nano>( std::chrono::steady_clock::now()-start ).count();
+
+    return (pixels*BENCH_ITERATIONS)/nsec;
+}
+
+// Typical ZED calibration, scaled to the resolution
+StereoParameters defaultParameters( int width, int height )
+{
+    StereoParameters params;
+    double scale = width/2208.0;
+
+    params.left.fx = 1400.0*scale;
+    params.left.fy = 1400.0*scale;
+    params.left.cx = width/2.0 + 8.0*scale;
+    params.left.cy = height/2.0 - 5.0*scale;
+    params.left.k1 = -0.172;
+    params.left.k2 = 0.027;
+
+    params.right = params.left;
+    params.right.cx = width/2.0 - 6.0*scale;
+    params.right.cy = height/2.0 + 3.0*scale;
+    params.right.k1 = -0.170;
+
+    params.baseline = 120.0;
+    params.ty = 0.2;
+    params.tz = -0.4;
+    params.rx = 0.002;
+    params.ry = 0.011;
+    params.rz = -0.0015;
+
+    return params;
+}
+
+// Max absolute difference of the rectified eye images
+double maxDifference( const cv::Mat reference[2], const cv::Mat result[2] )
+{
+    double maxDiff = 0.0;
+    for( int k=0; k<2; k++ )
+    {
+        double minVal, maxVal;
+        cv::Mat diff;
+        cv::absdiff( reference[k], result[k], diff );
+        cv::minMaxLoc( diff.reshape(1), &minVal, &maxVal );
+        maxDiff = std::max( maxDiff, maxVal );
+    }
+    return maxDiff;
+}
+
+// OpenCV rectification maps of the same calibration
+void opencvMaps( const StereoParameters& params, int width, int height, cv::Mat maps[2][2] )
+{
+    const CameraParameters* cams[2] = {&params.left, &params.right};
+    cv::Mat K[2], D[2];
+    for( int k=0; k<2; k++ )
+    {
+        K[k] = (cv::Mat_<double>(3,3) << cams[k]->fx, 0, cams[k]->cx, 0, cams[k]->fy, cams[k]->cy, 0, 0, 1);
+        D[k] = (cv::Mat_<double>(5,1) << cams[k]->k1, cams[k]->k2, cams[k]->p1, cams[k]->p2, cams[k]->k3);
+    }
+
+    cv::Mat om = (cv::Mat_<double>(3,1) << params.rx, params.ry, params.rz);
+    cv::Mat R;
+    cv::Rodrigues( om, R );
+    cv::Mat T = (cv::Mat_<double>(3,1) << params.baseline, params.ty, params.tz);
+
+    cv::Mat R1, R2, P1, P2, Q;
+    cv::Size size(width,height);
+    cv::stereoRectify( K[0], D[0], K[1], D[1], size, R, T, R1, R2, P1, P2, Q, cv::CALIB_ZERO_DISPARITY, 0, size );
+
+    cv::initUndistortRectifyMap( K[0], D[0], R1, P1, size, CV_32FC1, maps[0][0], maps[0][1] );
+    cv::initUndistortRectifyMap( K[1], D[1], R2, P2, size, CV_32FC1, maps[1][0], maps[1][1] );
+}
+
+ImageView toImageView( const cv::Mat& img )
+{
+    ImageView view;
+    view.data = img.data;
+    view.width = img.cols;
+    view.height = img.rows;
+    view.step = img.step;
+    view.channels = img.channels();
+    return view;
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    const char* resNames[] = {"HD2K", "HD1080", "HD720", "VGA"};
+
+    const CONVERSION_KERNEL kernels[] = {CONVERSION_KERNEL::SCALAR, CONVERSION_KERNEL::SSE4, CONVERSION_KERNEL::AVX2,
+                                        CONVERSION_KERNEL::NEON};
+    const char* kernelNames[] = {"AUTO", "SCALAR", "SSE4", "AVX2", "NEON"};
+
+    StereoCalibration calib;
+    if( argc>1 )
+    {
+        std::cout << "Calibration file: " << argv[1] << std::endl;
+        if( !loadStereoCalibration( argv[1], calib ) )
+            std::cout << "No valid calibration in the file. Using a typical calibration" << std::endl;
+    }
+    else
+        std::cout << "Usage: " << argv[0] << " [calibration file]. Using a typical calibration" << std::endl;
+
+    std::cout << "Throughput of the rectification of both eyes in pixels/ns, " << BENCH_ITERATIONS
+              << " iterations. 'MT': all the CPU cores" << std::endl;
+    std::cout << "'YUYV>' rows convert and rectify a raw frame in one pass, the OpenCV columns include cv::cvtColor" << std::endl;
+
+    bool accurate = true;
+
+    for( int r=0; r<static_cast<int>(RESOLUTION::LAST); r++ )
+    {
+        int width = static_cast<int>(cameraResolution[r].width);
+        int height = static_cast<int>(cameraResolution[r].height);
+        size_t pixels = 2*static_cast<size_t>(width)*height;
+
+        // ----> Rectification tables
+        StereoParameters params = calib.isValid( static_cast<RESOLUTION>(r) ) ? calib.get( static_cast<RESOLUTION>(r) )
+                                                                              : defaultParameters( width, height );
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Rectifier rectifier;
+        if( !rectifier.initialize( params, static_cast<RESOLUTION>(r) ) )
+        {
+            std::cerr << "Cannot initialize the rectification of the " << resNames[r] << " resolution" << std::endl;
+            return EXIT_FAILURE;
+        }
+        double initMsec = std::chrono::duration<double,std::milli>( std::chrono::steady_clock::now()-start ).count();
+
+        start = std::chrono::steady_clock::now();
+        cv::Mat maps[2][2], fixedMaps[2][2];
+        opencvMaps( params, width, height, maps );
+        for( int k=0; k<2; k++ )
+            cv::convertMaps( maps[k][0], maps[k][1], fixedMaps[k][0], fixedMaps[k][1], CV_16SC2 );
+        double cvInitMsec = std::chrono::duration<double,std::milli>( std::chrono::steady_clock::now()-start ).count();
+        // <---- Rectification tables
+
+        std::cout << std::endl << resNames[r] << " (" << width << "x" << height << " per eye), tables: "
+                  << std::fixed << std::setprecision(1) << initMsec << " msec (OpenCV " << cvInitMsec << " msec)" << std::endl;
+        std::cout << std::setw(10) << "format" << std::setw(10) << "remap" << std::setw(10) << "remap16";
+        for( CONVERSION_KERNEL kernel : kernels )
+        {
+            if( setConversionKernel(kernel) )
+            {
+                std::cout << std::setw(10) << kernelNames[static_cast<int>(kernel)]
+                          << std::setw(10) << (std::string(kernelNames[static_cast<int>(kernel)])+" MT");
+            }
+        }
+        std::cout << std::setw(10) << "max diff" << std::endl;
+
+        for( int type : {CV_8UC1, CV_8UC3} )
+        {
+            // ----> Smooth random eye images, so that the sub-pixel differences of the maps give small differences
+            cv::Mat src[2], cvDst[2], dst[2];
+            for( int k=0; k<2; k++ )
+            {
+                src[k].create( height, width, type );
+                cv::randu( src[k], cv::Scalar::all(0), cv::Scalar::all(255) );
+                cv::GaussianBlur( src[k], src[k], cv::Size(0,0), 2.0 );
+                dst[k].create( height, width, type );
+            }
+            // <---- Smooth random eye images, so that the sub-pixel differences of the maps give small differences
+
+            std::cout << std::setw(10) << ((type==CV_8UC1)?"GRAY":"BGR") << std::fixed << std::setprecision(3);
+
+            // ----> OpenCV reference, float and fixed point maps
+            std::cout << std::setw(10) << benchmark( pixels, [&]() {
+                for( int k=0; k<2; k++ )
+                    cv::remap( src[k], cvDst[k], maps[k][0], maps[k][1], cv::INTER_LINEAR );
+            });
+            std::cout << std::setw(10) << benchmark( pixels, [&]() {
+                for( int k=0; k<2; k++ )
+                    cv::remap( src[k], cvDst[k], fixedMaps[k][0], fixedMaps[k][1], cv::INTER_LINEAR );
+            });
+            // <---- OpenCV reference, float and fixed point maps
+
+            // ----> Library kernels, single thread and multithreaded
+            for( CONVERSION_KERNEL kernel : kernels )
+            {
+                if( !setConversionKernel(kernel) )
+                    continue;
+
+                for( int threads : {1,0} )
+                {
+                    std::cout << std::setw(10) << benchmark( pixels, [&]() {
+                        rectifier.rectify( toImageView(src[0]), toImageView(src[1]), dst[0].data, dst[1].data, threads );
+                    });
+                }
+            }
+            // <---- Library kernels, single thread and multithreaded
+
+            // ----> Difference with OpenCV
+            for( int k=0; k<2; k++ )
+                cv::remap( src[k], cvDst[k], maps[k][0], maps[k][1], cv::INTER_LINEAR );
+
+            double maxDiff = maxDifference( cvDst, dst );
+            std::cout << std::setw(10) << static_cast<int>(maxDiff);
+            if( maxDiff > MAX_REMAP_DIFF )
+            {
+                std::cout << " > " << MAX_REMAP_DIFF << " FAILED";
+                accurate = false;
+            }
+            std::cout << std::endl;
+            // <---- Difference with OpenCV
+        }
+
+        // ----> Fused conversion and rectification of a YUV 4:2:2 frame, against cvtColor followed by remap
+        cv::Mat frameYUV( height, 2*width, CV_8UC2 );
+        cv::randu( frameYUV, cv::Scalar::all(0), cv::Scalar::all(255) );
+        cv::GaussianBlur( frameYUV, frameYUV, cv::Size(0,0), 2.0 );
+
+        Frame frame;
+        frame.data = frameYUV.data;
+        frame.width = 2*width;
+        frame.height = height;
+        frame.channels = 2;
+
+        for( COLOR_FORMAT format : {COLOR_FORMAT::GRAY, COLOR_FORMAT::BGR} )
+        {
+            int type = (format==COLOR_FORMAT::GRAY)?CV_8UC1:CV_8UC3;
+            int code = (format==COLOR_FORMAT::GRAY)?cv::COLOR_YUV2GRAY_YUYV:cv::COLOR_YUV2BGR_YUYV;
+
+            cv::Mat converted, cvDst[2], dst[2];
+            for( int k=0; k<2; k++ )
+                dst[k].create( height, width, type );
+
+            std::cout << std::setw(10) << ((format==COLOR_FORMAT::GRAY)?"YUYV>GRAY":"YUYV>BGR") << std::fixed << std::setprecision(3);
+
+            for( int fixed=0; fixed<2; fixed++ )
+            {
+                cv::Mat (&m)[2][2] = fixed?fixedMaps:maps;
+                std::cout << std::setw(10) << benchmark( pixels, [&]() {
+                    cv::cvtColor( frameYUV, converted, code );
+                    for( int k=0; k<2; k++ )
+                        cv::remap( cv::Mat(converted, cv::Rect(k*width,0,width,height)), cvDst[k], m[k][0], m[k][1], cv::INTER_LINEAR );
+                });
+            }
+
+            for( CONVERSION_KERNEL kernel : kernels )
+            {
+                if( !setConversionKernel(kernel) )
+                    continue;
+
+                for( int threads : {1,0} )
+                {
+                    std::cout << std::setw(10) << benchmark( pixels, [&]() {
+                        rectifier.rectify( frame, dst[0].data, dst[1].data, format, threads );
+                    });
+                }
+            }
+
+            cv::cvtColor( frameYUV, converted, code );
+            for( int k=0; k<2; k++ )
+                cv::remap( cv::Mat(converted, cv::Rect(k*width,0,width,height)), cvDst[k], maps[k][0], maps[k][1], cv::INTER_LINEAR );
+
+            double maxDiff = maxDifference( cvDst, dst );
+            std::cout << std::setw(10) << static_cast<int>(maxDiff);
+            if( maxDiff > MAX_CONVERSION_DIFF )
+            {
+                std::cout << " > " << MAX_CONVERSION_DIFF << " FAILED";
+                accurate = false;
+            }
+            std::cout << std::endl;
+        }
+        // <---- Fused conversion and rectification of a YUV 4:2:2 frame, against cvtColor followed by remap
+    }
+
+    setConversionKernel(CONVERSION_KERNEL::AUTO);
+
+    if( !accurate )
+    {
+        std::cerr << std::endl << "The rectification differs from OpenCV more than expected" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -24,6 +24,8 @@
 #include <string>
 
 #include "videocapture.hpp"
+#include "imageconversion.hpp"
+#include "rectifier.hpp"
 
 // OpenCV includes
 #include <opencv2/opencv.hpp>
@@ -64,31 +66,30 @@ int main(int argc, char** argv) {
     std::string calibration_file;
     // ZED Calibration
     unsigned int serial_number = sn;
-    // Download camera calibration file
-    if( !downloadCalibrationFile(serial_number, calibration_file) )
+
+    // ----> Initialize calibration
+    // The rectification tables are cached on disk: without connection the cached calibration is used
+    sl_oc::video::Rectifier rectifier(verbose);
+    if( downloadCalibrationFile(serial_number, calibration_file) )
+    {
+        std::cout << "Calibration file found. Loading..." << std::endl;
+        if( !rectifier.initialize(calibration_file, params.res, sn) )
+        {
+            std::cerr << "Could not initialize the rectification" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    else if( !rectifier.loadFromCache(sn, params.res) )
     {
         std::cerr << "Could not load calibration file from Stereolabs servers" << std::endl;
         return EXIT_FAILURE;
     }
-    std::cout << "Calibration file found. Loading..." << std::endl;
 
-    // ----> Frame size
-    int w,h;
-    cap.getFrameSize(w,h);
-    // <---- Frame size
-
-    // ----> Initialize calibration
-    cv::Mat map_left_x, map_left_y;
-    cv::Mat map_right_x, map_right_y;
-    cv::Mat cameraMatrix_left, cameraMatrix_right;
-    initCalibration(calibration_file, cv::Size(w/2,h), map_left_x, map_left_y, map_right_x, map_right_y,
-                    cameraMatrix_left, cameraMatrix_right);
-
-    std::cout << " Camera Matrix L: \n" << cameraMatrix_left << std::endl << std::endl;
-    std::cout << " Camera Matrix R: \n" << cameraMatrix_right << std::endl << std::endl;
+    std::cout << " Camera Matrix L: \n" << cv::Mat(3, 4, CV_64F, const_cast<double*>(rectifier.getLeftCamera().P)) << std::endl << std::endl;
+    std::cout << " Camera Matrix R: \n" << cv::Mat(3, 4, CV_64F, const_cast<double*>(rectifier.getRightCamera().P)) << std::endl << std::endl;
     // ----> Initialize calibration
 
-    cv::Mat frameBGR, left_raw, left_rect, right_raw, right_rect;
+    cv::Mat left_raw, left_rect, right_raw, right_rect;
 
     uint64_t last_ts=0;
 
@@ -103,26 +104,24 @@ int main(int argc, char** argv) {
         {
             last_ts = frame.timestamp;
 
-            // ----> Conversion from YUV 4:2:2 to BGR for visualization
-            cv::Mat frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, frame.data );
-            cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
-            // <---- Conversion from YUV 4:2:2 to BGR for visualization
+            // ----> Conversion from YUV 4:2:2 to BGR, directly to dense left and right images
+            left_raw.create( frame.height, frame.width/2, CV_8UC3 );
+            right_raw.create( frame.height, frame.width/2, CV_8UC3 );
+            sl_oc::video::convertStereo( frame, left_raw.data, right_raw.data, sl_oc::video::COLOR_FORMAT::BGR );
 
-            // ----> Extract left and right images from side-by-sideq
-            left_raw = frameBGR(cv::Rect(0, 0, frameBGR.cols / 2, frameBGR.rows));
-            right_raw = frameBGR(cv::Rect(frameBGR.cols / 2, 0, frameBGR.cols / 2, frameBGR.rows));
             // Display images
             showImage("left RAW", left_raw, params.res);
             showImage("right RAW", right_raw, params.res);
-            // <---- Extract left and right images from side-by-side
+            // <---- Conversion from YUV 4:2:2 to BGR, directly to dense left and right images
 
-            // ----> Apply rectification
-            cv::remap(left_raw, left_rect, map_left_x, map_left_y, cv::INTER_LINEAR );
-            cv::remap(right_raw, right_rect, map_right_x, map_right_y, cv::INTER_LINEAR );
+            // ----> Apply rectification, converting the YUV 4:2:2 frame in the same pass
+            left_rect.create( frame.height, frame.width/2, CV_8UC3 );
+            right_rect.create( frame.height, frame.width/2, CV_8UC3 );
+            rectifier.rectify( frame, left_rect.data, right_rect.data, sl_oc::video::COLOR_FORMAT::BGR );
 
             showImage("right RECT", right_rect, params.res);
             showImage("left RECT", left_rect, params.res);
-            // <---- Apply rectification
+            // <---- Apply rectification, converting the YUV 4:2:2 frame in the same pass
         }
 
         // ----> Keyboard handling
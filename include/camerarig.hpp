@@ -0,0 +1,220 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CAMERARIG_HPP
+#define CAMERARIG_HPP
+
+#include "videocapture.hpp"
+#include "timeservice.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace sl_oc {
+
+#ifdef SENSORS_MOD_AVAILABLE
+namespace sensors {
+class SensorCapture;
+}
+#endif
+
+namespace video {
+
+/*!
+ * \brief The camera rig configuration parameters
+ */
+struct SL_OC_EXPORT RigParams
+{
+    /*!
+     * \brief Default constructor setting the default parameter values
+     */
+    RigParams() {
+        io_threads = 1;
+        max_sync_distance = 0;
+        open_sensors = false;
+    }
+
+    VideoParams video;          //!< Parameters used for all the cameras. Enable the frame history (see \ref VideoParams::history_depth) to align the frames on past timestamps
+    std::vector<int> serials;   //!< Serial numbers of the cameras to open, all the connected cameras if empty
+    uint8_t io_threads;         //!< Number of threads shared by all the cameras to grab the frames
+    uint64_t max_sync_distance; //!< Maximum distance in nanoseconds of a frame from the timestamp of its frame set, `0` for half the frame period
+    bool open_sensors;          //!< Open the sensors of each camera and synchronize them with the video. Only with the sensors module
+};
+
+/*!
+ * \brief A set of frames grabbed by the cameras of a rig close to a common timestamp
+ */
+struct SL_OC_EXPORT FrameSet
+{
+    uint64_t set_id = 0;            //!< Increasing index of frame sets
+    uint64_t timestamp = 0;         //!< Common timestamp of the frames in nanoseconds, in the host clock domain
+    uint64_t max_skew = 0;          //!< Maximum distance in nanoseconds of the frames from `timestamp`
+    std::vector<FrameLease> frames; //!< One lease per camera, in the camera order of the rig. A lease is not valid if the camera has no frame close enough to `timestamp`
+    std::vector<uint64_t> host_timestamps; //!< Timestamp of each frame converted to the host clock domain, `0` for the missing frames
+
+    /*!
+     * \brief Indicates if the set contains a frame for each camera
+     * \return true if all the leases are valid
+     */
+    bool isComplete() const;
+};
+
+/*!
+ * \brief Health and statistics of a camera of a rig
+ */
+struct SL_OC_EXPORT RigCameraStats
+{
+    int serial_number = -1;         //!< Serial number of the camera
+    int video_id = -1;              //!< ID of the video device (see `/dev/video*`)
+    bool healthy = false;           //!< The camera is streaming and grabbed a frame in the last five frame periods
+    uint64_t last_frame_age = 0;    //!< Time since the last grabbed frame in nanoseconds
+    uint64_t frame_sets = 0;        //!< Number of frame sets including a frame of the camera
+    uint64_t sync_misses = 0;       //!< Number of frame sets without a frame of the camera (timeout or frame too far from the set timestamp)
+    CaptureStats capture;           //!< Grabbing statistics of the camera
+    ClockEstimate clock;            //!< Offset and drift of the camera clock against the host clock
+};
+
+/*!
+ * \brief The CameraRig class opens a group of cameras in parallel, grabs their frames with a small pool of threads
+ * shared by all the cameras and delivers time aligned frame sets.
+ *
+ * Each camera keeps its frame ring, subscribers and controls, available with \ref getCamera.
+ *
+ * The timestamps of each camera are built from its own clock: the rig continuously estimates the offset and the
+ * drift of each camera clock against the host clock from the frame arrival times (see \ref TimeService) and aligns
+ * the frame sets in the host clock domain.
+ */
+class SL_OC_EXPORT CameraRig
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the rig parameters
+     */
+    CameraRig( const RigParams& params = RigParams() );
+
+    /*!
+     * \brief The class destructor, closes the cameras
+     */
+    virtual ~CameraRig();
+
+    /*!
+     * \brief Open all the cameras in parallel and start grabbing
+     * \return true if all the cameras have been opened. The cameras that cannot be opened are not part of the rig.
+     */
+    bool open();
+
+    /*!
+     * \brief Stop grabbing and close all the cameras
+     *
+     * \note All the frame sets must be released before closing the rig.
+     */
+    void close();
+
+    /*!
+     * \brief Get the number of opened cameras
+     * \return the number of cameras of the rig
+     */
+    size_t getCameraCount() const {return mCameras.size();}
+
+    /*!
+     * \brief Get a camera of the rig
+     * \param idx the index of the camera, cameras are sorted by serial number
+     * \return the camera, `nullptr` if the index is not valid
+     */
+    VideoCapture* getCamera( size_t idx );
+
+#ifdef SENSORS_MOD_AVAILABLE
+    /*!
+     * \brief Get the sensors of a camera of the rig
+     * \param idx the index of the camera
+     * \return the sensors of the camera, `nullptr` if the index is not valid or the sensors are not opened
+     */
+    sensors::SensorCapture* getSensors( size_t idx );
+#endif
+
+    /*!
+     * \brief Wait for a new frame from each camera and build the frame set closest to their common timestamp
+     * \param set the frame set, the leases of the previous set are released
+     * \param timeout_msec the maximum time to wait for the frames of each camera
+     * \return true if the set contains at least a frame
+     *
+     * The set timestamp is the host timestamp of the oldest new frame: the other cameras use their frame of the
+     * frame history closest to it when it is nearer than their newest frame.
+     */
+    bool grabFrameSet( FrameSet& set, uint64_t timeout_msec=100 );
+
+    /*!
+     * \brief Convert a timestamp of a camera to the host clock domain
+     * \param idx the index of the camera
+     * \param timestamp a frame timestamp of the camera, or an IMU timestamp of its sensors, in nanoseconds
+     * \return the timestamp in the host clock domain, `timestamp` if the camera clock has not been estimated yet
+     *
+     * \note The sensors opened by the rig are synchronized with the video of their camera, so their timestamps
+     * share the camera clock.
+     */
+    uint64_t toHostTime( size_t idx, uint64_t timestamp );
+
+    /*!
+     * \brief Get the estimator of the camera clocks, the clock identifier is the camera index
+     * \return the clock estimator
+     */
+    TimeService& getTimeService() {return mTimeService;}
+
+    /*!
+     * \brief Get the health and the statistics of each camera
+     * \return the statistics, in the camera order of the rig
+     */
+    std::vector<RigCameraStats> getStats();
+
+private:
+    struct RigCamera;
+
+    bool openCamera( RigCamera& cam, int video_id, int sn ); //!< Open the video device of a camera
+    void openSensors( RigCamera& cam );         //!< Open the sensors of an opened camera, hidapi is not thread safe
+    void ioThreadFunc( size_t thread_idx );     //!< Grab the frames of the cameras assigned to the thread
+
+    RigParams mParams;                          //!< Rig parameters
+    uint64_t mFramePeriod = 0;                  //!< Frame period in nanoseconds
+
+    std::vector<std::unique_ptr<RigCamera>> mCameras; //!< The opened cameras
+
+    std::vector<std::thread> mIoThreads;        //!< Threads grabbing the frames
+    std::vector<int> mIoEventFds;               //!< Events used to stop the grabbing threads
+    std::atomic<bool> mStop{true};              //!< Indicates if the grabbing threads must be stopped
+
+    uint64_t mSetCount = 0;                     //!< Number of delivered frame sets
+    TimeService mTimeService;                   //!< Estimator of the camera clocks
+    std::mutex mStatsMutex;                     //!< Mutex for safe access to the per camera frame set counters
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // CAMERARIG_HPP
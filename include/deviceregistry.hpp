@@ -0,0 +1,108 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef DEVICEREGISTRY_HPP
+#define DEVICEREGISTRY_HPP
+
+#include "defines.hpp"
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+namespace sl_oc {
+
+/*!
+ * \brief A physical Stereolabs camera, with its video device and its sensors MCU
+ */
+struct SL_OC_EXPORT CameraDevice
+{
+    int serial_number = -1;     //!< Serial number of the camera, `-1` if not available
+    std::string model;          //!< Name of the camera model (e.g. "ZED 2")
+
+    uint16_t video_pid = 0;     //!< Product ID of the video device, `0` if not found
+    std::string video_usb_path; //!< USB topology path of the video device (e.g. 2-1.1)
+    int video_id = -1;          //!< ID of the video device (see `/dev/video*`), `-1` if not found
+    std::string video_dev;      //!< Path of the video device (e.g. /dev/video0)
+
+    uint16_t mcu_pid = 0;       //!< Product ID of the sensors MCU, `0` if the camera has no sensors
+    std::string mcu_usb_path;   //!< USB topology path of the sensors MCU
+    std::string hidraw_dev;     //!< Path of the sensors MCU HID device (e.g. /dev/hidraw0)
+    uint16_t mcu_fw_version = 0;//!< Firmware version of the sensors MCU (major in the high byte, minor in the low byte)
+};
+
+/*!
+ * \brief The DeviceRegistry class lists the connected Stereolabs cameras, pairing the video devices and the sensors
+ * MCUs of each camera from the USB topology. The results are cached and shared by the video and the sensors modules.
+ *
+ * \note The devices are read from sysfs in a single pass, without opening them.
+ */
+class SL_OC_EXPORT DeviceRegistry
+{
+public:
+    /*!
+     * \brief Get the registry instance
+     * \return the registry instance
+     */
+    static DeviceRegistry& instance();
+
+    /*!
+     * \brief Get the connected cameras
+     * \param refresh scan the devices again instead of using the cached list
+     * \return the connected cameras sorted by serial number
+     */
+    std::vector<CameraDevice> getDevices( bool refresh=false );
+
+    /*!
+     * \brief Find a camera by serial number
+     * \param sn the serial number
+     * \param dev the found camera
+     * \return true if the camera is connected
+     */
+    bool findBySerial( int sn, CameraDevice& dev );
+
+    /*!
+     * \brief Find the camera using the given video device
+     * \param video_id the ID of the video device (see `/dev/video*`)
+     * \param dev the found camera
+     * \return true if the camera is connected
+     */
+    bool findByVideoId( int video_id, CameraDevice& dev );
+
+    /*!
+     * \brief Scan the connected devices again
+     */
+    void refresh();
+
+private:
+    DeviceRegistry() = default;
+    DeviceRegistry(const DeviceRegistry&) = delete;
+    DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+
+    void scanLocked();                  //!< Scan the devices, `mMutex` must be locked
+
+    std::vector<CameraDevice> mDevices; //!< The cached list of cameras
+    bool mScanned = false;              //!< Indicates if the devices have been scanned
+    std::mutex mMutex;                  //!< Mutex for safe access to the list of cameras
+};
+
+}
+
+#endif // DEVICEREGISTRY_HPP
@@ -0,0 +1,262 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef IMAGECONVERSION_HPP
+#define IMAGECONVERSION_HPP
+
+#include "videocapture.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Output formats of the YUV 4:2:2 (YUYV) frame conversion
+ */
+enum class COLOR_FORMAT {
+    BGR,        //!< Packed 8 bit BGR, 3 bytes per pixel
+    RGB,        //!< Packed 8 bit RGB, 3 bytes per pixel
+    BGRA,       //!< Packed 8 bit BGRA, 4 bytes per pixel, alpha set to 255
+    RGBA,       //!< Packed 8 bit RGBA, 4 bytes per pixel, alpha set to 255
+    GRAY,       //!< 8 bit luma, 1 byte per pixel
+    YUV422P     //!< Planar YUV 4:2:2: Y plane followed by the U and the V planes at half horizontal resolution
+};
+
+/*!
+ * \brief Instruction sets used by the conversion kernels
+ */
+enum class CONVERSION_KERNEL {
+    AUTO,       //!< The fastest kernel supported by the CPU
+    SCALAR,     //!< Portable C++ kernel
+    SSE4,       //!< SSE4.1 kernel (x86)
+    AVX2,       //!< AVX2 kernel (x86)
+    NEON        //!< NEON kernel (ARM)
+};
+
+/*!
+ * \brief Left and right views of a side by side frame
+ */
+struct SL_OC_EXPORT StereoView
+{
+    uint64_t frame_id = 0;          //!< ID of the frame
+    uint64_t timestamp = 0;         //!< Timestamp of the frame in nanoseconds
+    ImageView left;                 //!< Left image
+    ImageView right;                //!< Right image
+};
+
+/*!
+ * \brief Get the left and right views of a side by side frame, without copies
+ * \param frame the frame, its data must remain valid while the views are used (e.g. hold its \ref FrameLease)
+ * \return the stereo views, not valid if the frame has no data
+ */
+SL_OC_EXPORT StereoView splitStereo( const Frame& frame );
+
+/*!
+ * \brief Get the number of bytes per pixel of a packed format, `1` for \ref COLOR_FORMAT::YUV422P (Y plane)
+ * \param format the output format
+ * \return the number of bytes per pixel
+ */
+SL_OC_EXPORT int getColorFormatChannels( COLOR_FORMAT format );
+
+/*!
+ * \brief Get the size of a converted image with rows without padding
+ * \param width the image width in pixels
+ * \param height the image height in pixels
+ * \param format the output format
+ * \return the size in bytes
+ */
+SL_OC_EXPORT size_t getConvertedSize( int width, int height, COLOR_FORMAT format );
+
+/*!
+ * \brief Convert a YUV 4:2:2 (YUYV) image using BT.601 limited range coefficients, as `cv::COLOR_YUV2BGR_YUYV`
+ * \param src the YUYV image
+ * \param src_step the size in bytes of a row of `src`
+ * \param dst the destination buffer
+ * \param dst_step the size in bytes of a row of `dst`. For \ref COLOR_FORMAT::YUV422P it is the row size of the
+ * Y plane: the U and V planes use half of it and follow the Y plane
+ * \param width the image width in pixels, must be even
+ * \param height the image height in pixels
+ * \param format the output format
+ * \param threads the maximum number of threads converting row bands in parallel, `0` for all the CPU cores
+ * \return true if the image has been converted
+ *
+ * \note All the kernels give the same result bit by bit. The difference with `cv::cvtColor` is at most one level.
+ */
+SL_OC_EXPORT bool convertYUYV( const uint8_t* src, size_t src_step, uint8_t* dst, size_t dst_step,
+                               int width, int height, COLOR_FORMAT format, int threads=0 );
+
+/*!
+ * \brief Convert a grabbed frame to a buffer with rows without padding
+ * \param frame the frame to convert
+ * \param dst the destination buffer of \ref getConvertedSize bytes
+ * \param format the output format
+ * \param threads the maximum number of threads converting row bands in parallel, `0` for all the CPU cores
+ * \return true if the frame has been converted
+ */
+SL_OC_EXPORT bool convertFrame( const Frame& frame, uint8_t* dst, COLOR_FORMAT format, int threads=0 );
+
+/*!
+ * \brief Convert a YUV 4:2:2 view (e.g. an eye of \ref splitStereo) to a buffer with rows without padding
+ * \param view the view to convert
+ * \param dst the destination buffer of \ref getConvertedSize bytes
+ * \param format the output format
+ * \param threads the maximum number of threads converting row bands in parallel, `0` for all the CPU cores
+ * \return true if the view has been converted
+ */
+SL_OC_EXPORT bool convertView( const ImageView& view, uint8_t* dst, COLOR_FORMAT format, int threads=0 );
+
+/*!
+ * \brief Convert a side by side frame to two dense images, one per eye, in a single pass over the frame
+ * \param frame the frame to convert
+ * \param left the destination buffer of the left image, \ref getConvertedSize bytes for half of the frame width
+ * \param right the destination buffer of the right image
+ * \param format the output format
+ * \param threads the maximum number of threads converting row bands in parallel, `0` for all the CPU cores
+ * \return true if the frame has been converted
+ */
+SL_OC_EXPORT bool convertStereo( const Frame& frame, uint8_t* left, uint8_t* right, COLOR_FORMAT format, int threads=0 );
+
+/*!
+ * \brief Downsample a YUV 4:2:2 (YUYV) image by two in each direction, averaging 2x2 pixel blocks
+ * \param src the YUYV image
+ * \param src_step the size in bytes of a row of `src`
+ * \param dst the destination YUYV image
+ * \param dst_step the size in bytes of a row of `dst`
+ * \param width the source width in pixels. The destination width is `width/2` rounded down to an even number
+ * \param height the source height in pixels. The destination height is `height/2` rounded down
+ * \param threads the maximum number of threads downsampling row bands in parallel, `0` for all the CPU cores
+ * \return true if the image has been downsampled
+ */
+SL_OC_EXPORT bool downsampleYUYV( const uint8_t* src, size_t src_step, uint8_t* dst, size_t dst_step,
+                                  int width, int height, int threads=0 );
+
+/*!
+ * \brief Fixed point remap table, e.g. a rectification map (see \ref Rectifier)
+ *
+ * Each destination pixel stores the integer coordinates of the top left pixel of its 2x2 source neighbourhood
+ * and its position inside the neighbourhood in 1/32 of pixel, as bilinear weights. Source pixels outside the
+ * image are black.
+ */
+struct SL_OC_EXPORT RemapTable
+{
+    int width = 0;                  //!< Width of the destination image
+    int height = 0;                 //!< Height of the destination image
+    int src_width = 0;              //!< Width of the source image
+    int src_height = 0;             //!< Height of the source image
+    int16_t* xy = nullptr;          //!< Integer source coordinates, `x` and `y` of each destination pixel
+    uint16_t* frac = nullptr;       //!< Fractional source coordinates, `fx + 32*fy` of each destination pixel
+    uint8_t* border = nullptr;      //!< One flag for each block of 8 pixels of a row, set if the block reads close to or outside the image border
+    std::shared_ptr<uint8_t> memory;//!< Memory storing the table, allocated by \ref create or attached with \ref attach
+
+    /*!
+     * \brief Allocate the table, all the pixels mapped to the source origin
+     * \param width the destination width
+     * \param height the destination height
+     * \param src_width the source width
+     * \param src_height the source height
+     */
+    void create( int width, int height, int src_width, int src_height );
+
+    /*!
+     * \brief Use the data of a table stored in an external memory block, e.g. a memory mapped file
+     * \param width the destination width
+     * \param height the destination height
+     * \param src_width the source width
+     * \param src_height the source height
+     * \param data the table data, \ref getDataSize bytes aligned to 8 bytes: `xy`, then `frac`, then `border`
+     * \param owner the owner of the memory block, kept by the table
+     */
+    void attach( int width, int height, int src_width, int src_height, uint8_t* data, std::shared_ptr<uint8_t> owner );
+
+    /*!
+     * \brief Set the source position of a destination pixel
+     * \param x the destination column
+     * \param y the destination row
+     * \param src_x the source column, sub-pixel
+     * \param src_y the source row, sub-pixel
+     */
+    void set( int x, int y, float src_x, float src_y );
+
+    /*!
+     * \brief Get the size in bytes of the data of a table, padded to 8 bytes
+     * \param width the destination width
+     * \param height the destination height
+     */
+    static size_t getDataSize( int width, int height );
+
+    /*!
+     * \brief Indicates if the table has been created
+     */
+    inline bool isValid() const {return width>0 && height>0 && xy!=nullptr;}
+};
+
+/*!
+ * \brief Remap an image with bilinear interpolation
+ * \param src the source image, with 1, 3 or 4 channels, of the size of the table source
+ * \param table the remap table
+ * \param dst the destination image, of the size of the table
+ * \param dst_step the size in bytes of a row of `dst`
+ * \param threads the maximum number of threads remapping row bands in parallel, `0` for all the CPU cores
+ * \return true if the image has been remapped
+ *
+ * \note The SSE4 and AVX2 kernels give the same result as the scalar one; NEON uses the scalar kernel.
+ */
+SL_OC_EXPORT bool remapImage( const ImageView& src, const RemapTable& table, uint8_t* dst, size_t dst_step, int threads=0 );
+
+/*!
+ * \brief Remap a YUV 4:2:2 (YUYV) image and convert it in a single pass, e.g. to rectify an eye of a grabbed frame
+ * \param src the YUYV image (e.g. a view of \ref splitStereo), of the size of the table source
+ * \param table the remap table
+ * \param dst the destination image, of the size of the table
+ * \param dst_step the size in bytes of a row of `dst`
+ * \param format the output format, \ref COLOR_FORMAT::YUV422P is not supported
+ * \param threads the maximum number of threads remapping row bands in parallel, `0` for all the CPU cores
+ * \return true if the image has been remapped
+ *
+ * \note The gray output is the same as \ref remapImage of the converted image. For the colors Y, U and V are
+ * interpolated before the conversion, so the result differs slightly from converting first, and the alpha
+ * channel is always 255.
+ */
+SL_OC_EXPORT bool remapYUYV( const ImageView& src, const RemapTable& table, uint8_t* dst, size_t dst_step,
+                             COLOR_FORMAT format, int threads=0 );
+
+/*!
+ * \brief Select the instruction set used by the conversion kernels
+ * \param kernel the kernel to use
+ * \return false if the kernel is not supported by the CPU
+ */
+SL_OC_EXPORT bool setConversionKernel( CONVERSION_KERNEL kernel );
+
+/*!
+ * \brief Get the instruction set used by the conversion kernels
+ * \return the kernel in use, never \ref CONVERSION_KERNEL::AUTO
+ */
+SL_OC_EXPORT CONVERSION_KERNEL getConversionKernel();
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // IMAGECONVERSION_HPP
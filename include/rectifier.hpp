@@ -0,0 +1,261 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef RECTIFIER_HPP
+#define RECTIFIER_HPP
+
+#include "imageconversion.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Intrinsic parameters of a camera, with the radial and tangential distortion coefficients
+ */
+struct SL_OC_EXPORT CameraParameters
+{
+    double fx = 0.0;    //!< Focal length along x [pixels]
+    double fy = 0.0;    //!< Focal length along y [pixels]
+    double cx = 0.0;    //!< Principal point x [pixels]
+    double cy = 0.0;    //!< Principal point y [pixels]
+    double k1 = 0.0;    //!< First radial distortion coefficient
+    double k2 = 0.0;    //!< Second radial distortion coefficient
+    double p1 = 0.0;    //!< First tangential distortion coefficient
+    double p2 = 0.0;    //!< Second tangential distortion coefficient
+    double k3 = 0.0;    //!< Third radial distortion coefficient
+};
+
+/*!
+ * \brief Calibration of a stereo camera at a given resolution, as stored in the ZED calibration files
+ */
+struct SL_OC_EXPORT StereoParameters
+{
+    CameraParameters left;  //!< Left camera
+    CameraParameters right; //!< Right camera
+    double baseline = 0.0;  //!< Translation of the right camera along x [mm]
+    double ty = 0.0;        //!< Translation of the right camera along y [mm]
+    double tz = 0.0;        //!< Translation of the right camera along z [mm]
+    double rx = 0.0;        //!< Rotation of the right camera, x component of the Rodrigues vector [rad]
+    double ry = 0.0;        //!< Rotation of the right camera, y component of the Rodrigues vector [rad] (`cv` key)
+    double rz = 0.0;        //!< Rotation of the right camera, z component of the Rodrigues vector [rad]
+};
+
+/*!
+ * \brief Geometry of a rectified camera
+ */
+struct SL_OC_EXPORT RectifiedCamera
+{
+    double P[12] = {};      //!< Projection matrix, 3x4 row major. `P[3]` is the focal length times the baseline for the right camera
+    double R[9] = {};       //!< Rotation from the original camera to the rectified one, 3x3 row major
+};
+
+/*!
+ * \brief Calibration of all the resolutions of a stereo camera, as stored in the ZED calibration files
+ */
+struct SL_OC_EXPORT StereoCalibration
+{
+    StereoParameters params[static_cast<int>(RESOLUTION::LAST)];   //!< Calibration of each resolution
+    bool valid[static_cast<int>(RESOLUTION::LAST)] = {};            //!< Indicates if the calibration of each resolution is complete and consistent
+
+    /*!
+     * \brief Indicates if the calibration of a resolution is available
+     */
+    inline bool isValid( RESOLUTION res ) const {return res<RESOLUTION::LAST && valid[static_cast<int>(res)];}
+
+    /*!
+     * \brief Get the calibration of a resolution, check \ref isValid first
+     */
+    inline const StereoParameters& get( RESOLUTION res ) const {return params[static_cast<int>(res)];}
+};
+
+/*!
+ * \brief Load all the resolutions of a ZED calibration file (e.g. `SN1234.conf`) in a single pass
+ *
+ * The section and key names are case insensitive and the values always use the `.` decimal separator,
+ * whatever the locale. A resolution is valid if the intrinsic parameters of both cameras and the baseline are
+ * present, all its values are well formed and \ref validateStereoParameters accepts them.
+ * \param calibration_file the path of the calibration file
+ * \param calib the loaded calibration
+ * \return false if the file cannot be read or does not contain any valid resolution
+ */
+SL_OC_EXPORT bool loadStereoCalibration( const std::string& calibration_file, StereoCalibration& calib );
+
+/*!
+ * \brief Check the consistency of the calibration of a resolution: positive focal lengths, principal points inside
+ *        the image, non null baseline and finite values
+ * \param params the calibration
+ * \param res the resolution
+ * \return false if the calibration cannot be used
+ */
+SL_OC_EXPORT bool validateStereoParameters( const StereoParameters& params, RESOLUTION res );
+
+/*!
+ * \brief Load the calibration of a resolution from a ZED calibration file (e.g. `SN1234.conf`)
+ * \param calibration_file the path of the calibration file
+ * \param res the resolution
+ * \param params the loaded calibration
+ * \return false if the file cannot be read or does not contain a valid calibration for the resolution
+ */
+SL_OC_EXPORT bool loadStereoParameters( const std::string& calibration_file, RESOLUTION res, StereoParameters& params );
+
+/*!
+ * \brief The Rectifier class rectifies the stereo images with fixed point remap tables, without OpenCV
+ *
+ * The rectification follows `cv::stereoRectify` with `CALIB_ZERO_DISPARITY` and `alpha=0` (only valid pixels
+ * are visible) and `cv::initUndistortRectifyMap`. The maps are stored as \ref RemapTable, 16 bit coordinates
+ * and 1/32 pixel bilinear weights, i.e. 6 bytes per pixel instead of the 8 of two float maps.
+ */
+class SL_OC_EXPORT Rectifier
+{
+    ZED_OC_VERSION_ATTRIBUTE;
+
+public:
+    /*!
+     * \brief The default constructor
+     * \param verbose the verbosity level
+     */
+    Rectifier( int verbose=VERBOSITY::ERROR );
+
+    /*!
+     * \brief Build the rectification tables of a resolution from a calibration
+     * \param params the calibration of the resolution
+     * \param res the resolution of the images to rectify
+     * \return false if the calibration is not valid
+     */
+    bool initialize( const StereoParameters& params, RESOLUTION res );
+
+    /*!
+     * \brief Build the rectification tables of a resolution from a ZED calibration file
+     * \param calibration_file the path of the calibration file
+     * \param res the resolution of the images to rectify
+     * \return false if the file cannot be loaded or the calibration is not valid
+     */
+    bool initialize( const std::string& calibration_file, RESOLUTION res );
+
+    /*!
+     * \brief Initialize the rectification of a camera from its calibration file, using the on disk cache
+     *
+     * The calibration and the remap tables are stored in the cache directory (see \ref getCacheDir),
+     * keyed by serial number, resolution and a hash of the calibration file. When a valid cache entry exists
+     * the tables are memory mapped instead of being computed, so that the processes using the same camera share them.
+     * \param calibration_file the path of the calibration file
+     * \param res the resolution of the images to rectify
+     * \param serial_number the serial number of the camera
+     * \return false if neither the cache nor the file contain a valid calibration
+     */
+    bool initialize( const std::string& calibration_file, RESOLUTION res, int serial_number );
+
+    /*!
+     * \brief Initialize the rectification of a camera from the on disk cache only, e.g. when the calibration
+     *        file cannot be downloaded
+     * \param serial_number the serial number of the camera
+     * \param res the resolution of the images to rectify
+     * \return false if the resolution is not valid or the cache does not contain the camera at this resolution
+     */
+    bool loadFromCache( int serial_number, RESOLUTION res );
+
+    /*!
+     * \brief Get the directory storing the calibration files and the rectification cache (`$HOME/zed/settings/`)
+     */
+    static std::string getCacheDir();
+
+    /*!
+     * \brief Indicates if the rectification tables are available
+     */
+    inline bool isInitialized() const {return mInitialized;}
+
+    /*!
+     * \brief Rectify the left and right images
+     * \param left the left image, with 1, 3 or 4 channels (e.g. converted with \ref convertStereo)
+     * \param right the right image, with the same format
+     * \param left_dst the destination buffer of the rectified left image, rows without padding
+     * \param right_dst the destination buffer of the rectified right image, rows without padding
+     * \param threads the maximum number of threads remapping row bands in parallel, `0` for all the CPU cores
+     * \return false if the images do not match the resolution of the tables
+     */
+    bool rectify( const ImageView& left, const ImageView& right, uint8_t* left_dst, uint8_t* right_dst, int threads=0 );
+
+    /*!
+     * \brief Rectify and convert the two eyes of a grabbed YUV 4:2:2 frame in a single pass (see \ref remapYUYV)
+     * \param frame the side by side YUYV frame
+     * \param left_dst the destination buffer of the rectified left image, rows without padding
+     * \param right_dst the destination buffer of the rectified right image, rows without padding
+     * \param format the output format, \ref COLOR_FORMAT::YUV422P is not supported
+     * \param threads the maximum number of threads remapping row bands in parallel, `0` for all the CPU cores
+     * \return false if the frame does not match the resolution of the tables
+     */
+    bool rectify( const Frame& frame, uint8_t* left_dst, uint8_t* right_dst, COLOR_FORMAT format, int threads=0 );
+
+    /*!
+     * \brief Get the calibration used to build the tables
+     */
+    inline const StereoParameters& getParameters() const {return mParams;}
+
+    /*!
+     * \brief Get the geometry of the rectified left camera
+     */
+    inline const RectifiedCamera& getLeftCamera() const {return mLeftCam;}
+
+    /*!
+     * \brief Get the geometry of the rectified right camera
+     */
+    inline const RectifiedCamera& getRightCamera() const {return mRightCam;}
+
+    /*!
+     * \brief Get the remap table of the left image
+     */
+    inline const RemapTable& getLeftTable() const {return mLeftTable;}
+
+    /*!
+     * \brief Get the remap table of the right image
+     */
+    inline const RemapTable& getRightTable() const {return mRightTable;}
+
+private:
+    void stereoRectify( int width, int height );    //!< Compute the rectified cameras
+    bool buildTable( const CameraParameters& cam, const RectifiedCamera& rect, int width, int height,
+                     RemapTable& table );           //!< Compute the remap table of a camera, false if the projection is degenerate
+    bool readCache( const std::string& path, int serial_number, RESOLUTION res,
+                    const uint64_t* calib_hash );   //!< Map a cache file, the hash is not checked if `nullptr`
+    bool writeCache( const std::string& path, int serial_number, RESOLUTION res,
+                     uint64_t calib_hash );         //!< Store the calibration and the tables in a cache file
+
+private:
+    int mVerbose;                   //!< Verbosity level
+    bool mInitialized = false;      //!< Indicates if the tables are available
+
+    StereoParameters mParams;       //!< Calibration of the resolution
+    RectifiedCamera mLeftCam;       //!< Rectified left camera
+    RectifiedCamera mRightCam;      //!< Rectified right camera
+    RemapTable mLeftTable;          //!< Remap table of the left image
+    RemapTable mRightTable;         //!< Remap table of the right image
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // RECTIFIER_HPP
@@ -213,7 +213,7 @@ private:
     bool startCapture();                //!< Start data capture thread
     void reset();                       //!< Reset  connection
 
-    int enumerateDevices();             //!< Populates the  mSlDevPid map with serial number and PID of the available devices
+    int enumerateDevices( bool refresh=false ); //!< Populates the  mSlDevPid map with serial number and PID of the available devices, `refresh` scans the devices again
 
     // ----> USB commands to MCU
     bool enableDataStream(bool enable); //!< Enable/Disable the data stream
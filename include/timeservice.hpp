@@ -0,0 +1,139 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TIMESERVICE_HPP
+#define TIMESERVICE_HPP
+
+#include "defines.hpp"
+
+#include <map>
+#include <deque>
+#include <mutex>
+
+namespace sl_oc {
+
+/*!
+ * \brief Estimated relation between a device clock and the host clock: `host = device + offset + drift*(device - ref_ts)`
+ */
+struct SL_OC_EXPORT ClockEstimate
+{
+    bool valid = false;         //!< Indicates if enough samples have been collected to estimate the drift
+    uint64_t ref_ts = 0;        //!< Device timestamp of the reference point of the estimate [nsec]
+    int64_t offset = 0;         //!< Host clock minus device clock at `ref_ts` [nsec]
+    double drift_ppm = 0.0;     //!< Drift of the device clock against the host clock [ppm]
+    double offset_stddev = 0.0; //!< Standard deviation of `offset` [nsec]
+    double drift_stddev = 0.0;  //!< Standard deviation of `drift_ppm` [ppm]
+    double residual_rms = 0.0;  //!< RMS of the fit residuals [nsec]
+    uint64_t samples = 0;       //!< Number of samples received
+};
+
+/*!
+ * \brief The TimeService class estimates the offset and the drift of several device clocks against the host clock
+ *
+ * Each sample pairs a device timestamp with the host time of the event it refers to, measured with a positive
+ * latency (e.g. the time a frame is dequeued from the driver). The minimum offset of each block of samples
+ * rejects the latency jitter, then the offset and the drift are fitted by least squares on a sliding window of
+ * block minima.
+ *
+ * \note The constant part of the transfer latency cannot be observed: it is included in the estimated offset
+ * and is the same for identical devices.
+ */
+class SL_OC_EXPORT TimeService
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param block_size number of samples reduced to their minimum offset
+     * \param window number of block minima used for the fit
+     */
+    TimeService( size_t block_size=8, size_t window=64 );
+
+    /*!
+     * \brief Add a sample to the estimation of a clock
+     * \param clock_id the identifier of the device clock
+     * \param device_ts the device timestamp [nsec]
+     * \param host_ts the host time of the same event [nsec]
+     */
+    void addSample( int clock_id, uint64_t device_ts, uint64_t host_ts );
+
+    /*!
+     * \brief Get the current estimate of a clock
+     * \param clock_id the identifier of the device clock
+     * \param estimate the estimate
+     * \return true if the clock has received at least a block of samples
+     */
+    bool getEstimate( int clock_id, ClockEstimate& estimate );
+
+    /*!
+     * \brief Convert a device timestamp to the host clock
+     * \param clock_id the identifier of the device clock
+     * \param device_ts the device timestamp [nsec]
+     * \return the host timestamp, `device_ts` if the clock has no estimate yet
+     */
+    uint64_t toHostTime( int clock_id, uint64_t device_ts );
+
+    /*!
+     * \brief Convert a host timestamp to a device clock
+     * \param clock_id the identifier of the device clock
+     * \param host_ts the host timestamp [nsec]
+     * \return the device timestamp, `host_ts` if the clock has no estimate yet
+     */
+    uint64_t toDeviceTime( int clock_id, uint64_t host_ts );
+
+    /*!
+     * \brief Discard the samples of a clock, e.g. after the device has been restarted
+     * \param clock_id the identifier of the device clock, `-1` for all the clocks
+     */
+    void reset( int clock_id=-1 );
+
+private:
+    /*!
+     * \brief Block minimum of the clock offset
+     */
+    struct OffsetPoint
+    {
+        uint64_t device_ts; //!< Device timestamp of the sample [nsec]
+        int64_t offset;     //!< Host minus device timestamp [nsec]
+    };
+
+    /*!
+     * \brief Estimation state of a clock
+     */
+    struct ClockState
+    {
+        OffsetPoint block_min;          //!< Minimum offset of the current block
+        size_t block_count = 0;         //!< Number of samples in the current block
+        std::deque<OffsetPoint> points; //!< Sliding window of block minima
+        ClockEstimate estimate;         //!< Last estimate
+    };
+
+    void fitLocked( ClockState& state );   //!< Update the estimate of a clock, `mMutex` must be locked
+
+    size_t mBlockSize;                  //!< Number of samples per block
+    size_t mWindow;                     //!< Number of block minima in the sliding window
+
+    std::map<int,ClockState> mClocks;   //!< Estimation state of each clock
+    std::mutex mMutex;                  //!< Mutex for safe access to the clocks
+};
+
+}
+
+#endif // TIMESERVICE_HPP
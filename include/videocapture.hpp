@@ -24,11 +24,21 @@
 #include "defines.hpp"
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <map>
+#include <deque>
+#include <vector>
+#include <future>
 
 #ifdef VIDEO_MOD_AVAILABLE
 
 #include "videocapture_def.hpp"
 
+struct v4l2_buffer;
+
 namespace sl_oc {
 
 
@@ -41,6 +51,38 @@ class SensorCapture;
 
 namespace video {
 
+/*!
+ * \brief Descriptor of an image stored in a buffer owned by someone else, e.g. one eye of a side by side frame
+ */
+struct SL_OC_EXPORT ImageView
+{
+    const uint8_t* data = nullptr;  //!< Address of the first pixel, `nullptr` if the view is not valid
+    int width = 0;                  //!< Image width in pixels
+    int height = 0;                 //!< Image height in pixels
+    size_t step = 0;                //!< Size in bytes of a row including the padding, e.g. the other eye
+    int channels = 0;               //!< Number of bytes per pixel, `2` for YUV 4:2:2
+
+    /*!
+     * \brief Get the address of a row
+     * \param y the row index
+     * \return the address of the first pixel of the row
+     */
+    inline const uint8_t* row( int y ) const {return data + y*step;}
+};
+
+/*!
+ * \brief Multi-level image pyramid of the two eyes of a frame (see \ref VideoParams::pyramid_levels)
+ *
+ * Level `0` is half the resolution of an eye, each following level halves the previous one.
+ * All the levels are stored in a single 64 bytes aligned allocation, with rows padded to 64 bytes.
+ */
+struct SL_OC_EXPORT FramePyramid
+{
+    std::vector<ImageView> left;    //!< Levels of the left eye, from the largest to the smallest
+    std::vector<ImageView> right;   //!< Levels of the right eye, from the largest to the smallest
+    std::shared_ptr<uint8_t> memory;//!< Memory storing all the levels
+};
+
 /*!
  * \brief The Frame struct containing the acquired video frames
  */
@@ -48,10 +90,147 @@ struct SL_OC_EXPORT Frame
 {
     uint64_t frame_id = 0;          //!< Increasing index of frames
     uint64_t timestamp = 0;         //!< Timestamp in nanoseconds
+    uint64_t arrival_ts = 0;        //!< Wall clock time in nanoseconds when the frame was dequeued from the driver (see \ref getWallTimestamp)
     uint8_t* data = nullptr;        //!< Frame data in YUV 4:2:2 format
     uint16_t width = 0;             //!< Frame width
     uint16_t height = 0;            //!< Frame height
     uint8_t channels = 0;           //!< Number of channels per pixel
+    int dmabuf_fd = -1;             //!< DMABUF file descriptor of the UVC buffer holding the frame, -1 if not available
+    size_t dmabuf_size = 0;         //!< Size of the DMABUF buffer
+    const FramePyramid* pyramid = nullptr; //!< Image pyramid of the frame, only for the frames copied by the library when \ref VideoParams::pyramid_levels is not `0`
+};
+
+/*!
+ * \brief Information about a connected camera, retrieved without opening it (see \ref VideoCapture::enumerate)
+ */
+struct SL_OC_EXPORT VideoDeviceInfo
+{
+    int id = -1;                        //!< ID of the video device (see `/dev/video*`)
+    std::string dev_name;               //!< Path of the video device (e.g. /dev/video0)
+    SL_DEVICE model = SL_DEVICE::NONE;  //!< The camera model
+    std::string usb_path;               //!< USB topology path of the camera (e.g. 2-1.3)
+    int serial_number = -1;             //!< Serial number of the camera, `-1` if not available without opening it
+};
+
+class VideoCapture;
+
+/*!
+ * \brief The FrameLease class gives zero-copy access to a frame still stored in the UVC buffer it was grabbed into
+ *
+ * The UVC buffer is given back to the driver only when the last lease referring to it is released, so a lease
+ * should be kept only for the time required to process the frame: while a buffer is leased it cannot be used
+ * to grab new frames.
+ *
+ * \note A lease must be released before the VideoCapture object that generated it is destroyed.
+ */
+class SL_OC_EXPORT FrameLease
+{
+public:
+    /*!
+     * \brief Default constructor, creates an invalid lease
+     */
+    FrameLease() = default;
+
+    /*!
+     * \brief The class destructor, releases the lease
+     */
+    ~FrameLease();
+
+    FrameLease(FrameLease&& other);                     //!< Move constructor
+    FrameLease& operator=(FrameLease&& other);          //!< Move assignment
+
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+
+    /*!
+     * \brief Indicates if the lease refers to a valid frame
+     * \return true if the lease is valid
+     */
+    inline bool isValid() const {return mCap!=nullptr;}
+
+    /*!
+     * \brief Get the leased frame. The `data` field points directly to the UVC buffer.
+     * \return a reference to the leased frame
+     *
+     * \note When \ref VideoParams::export_dmabuf is enabled the `dmabuf_fd` field refers to the same buffer and
+     * can be passed to another process or library (e.g. over a UNIX socket with `SCM_RIGHTS`) to import the frame
+     * without copies. The content of the buffer is valid only while the lease is held. The file descriptor is
+     * owned by the VideoCapture object and must not be closed.
+     */
+    inline const Frame& frame() const {return mFrame;}
+
+    /*!
+     * \brief Release the lease before its destruction. The lease is invalid after this call.
+     */
+    void release();
+
+    /*!
+     * \brief Indicates if the leased frame is a copy stored in the frame history
+     * \return true if the frame comes from the frame history
+     */
+    inline bool isFromHistory() const {return mHistory;}
+
+private:
+    friend class VideoCapture;
+    FrameLease(VideoCapture* cap, int index, const Frame& frame, bool history=false);
+
+    VideoCapture* mCap = nullptr;       //!< The VideoCapture object owning the leased buffer
+    int mIndex = -1;                    //!< Index of the leased UVC buffer or history slot
+    bool mHistory = false;              //!< Indicates if the lease refers to a history slot
+    Frame mFrame;                       //!< The leased frame
+};
+
+/*!
+ * \brief Callback called for each frame delivered to a subscriber (see \ref VideoCapture::subscribe)
+ */
+typedef std::function<void(FrameLease)> FrameCallback;
+
+/*!
+ * \brief The options of a frame subscriber (see \ref VideoCapture::subscribe)
+ */
+struct SL_OC_EXPORT SubscriberOptions
+{
+    uint32_t decimation = 1;    //!< Deliver one frame every `decimation` grabbed frames
+    size_t queue_depth = 1;     //!< Maximum number of frames waiting for the callback, the oldest is dropped when full
+};
+
+/*!
+ * \brief The statistics of a frame subscriber
+ */
+struct SL_OC_EXPORT SubscriberStats
+{
+    uint64_t delivered = 0;     //!< Number of frames passed to the callback
+    uint64_t dropped = 0;       //!< Number of frames dropped because the subscriber queue was full
+};
+
+/*!
+ * \brief A set of camera settings that can be captured, stored and applied at once
+ * (see \ref VideoCapture::getSettingsProfile and \ref VideoCapture::applySettingsProfile)
+ */
+struct SL_OC_EXPORT CameraSettingsProfile
+{
+    int brightness = 0;                 //!< Brightness value
+    int contrast = 0;                   //!< Contrast value
+    int hue = 0;                        //!< Hue value
+    int saturation = 0;                 //!< Saturation value
+    int sharpness = 0;                  //!< Sharpness value
+    int gamma = 1;                      //!< Gamma value in the range [1,9]
+    int white_balance = 0;              //!< White Balance temperature, used only if `auto_white_balance` is false
+    bool auto_white_balance = true;     //!< Status of the automatic White Balance control
+    bool aec_agc = true;                //!< Status of the automatic Exposure and Gain control
+
+    /*!
+     * \brief Serialize the profile as `key=value` lines
+     * \return the serialized profile
+     */
+    std::string toString() const;
+
+    /*!
+     * \brief Load a profile serialized by \ref toString. Missing keys keep their current value.
+     * \param str the serialized profile
+     * \return true if the string is valid
+     */
+    bool fromString(const std::string& str);
 };
 
 /*!
@@ -80,18 +259,148 @@ public:
      */
     bool initializeVideo( int devId=-1 );
 
+    /*!
+     * \brief Open the ZED camera with the given serial number
+     * \param sn the serial number of the camera
+     * \return returns true if the camera is correctly opened
+     */
+    bool initializeVideoBySerial( int sn );
+
+    /*!
+     * \brief Retrieve the list of the connected ZED cameras from the \ref DeviceRegistry, without opening them
+     * \param refresh scan the devices again instead of using the cached list, e.g. after a hot-plug.
+     *        The devices are scanned again anyway if the cached list contains no video device
+     * \return the information of each camera video device
+     *
+     * \note The serial number is available only if the camera exposes it in its USB descriptor, in the udev
+     * database or through its sensors MCU.
+     */
+    static std::vector<VideoDeviceInfo> enumerate( bool refresh=false );
+
+    /*!
+     * \brief Register the application buffers used to grab the frames with \ref BUFFER_MEMORY::USERPTR
+     * \param buffers the addresses of the buffers, their number sets the UVC buffer count
+     * \param length the size of each buffer, at least \ref getRequiredBufferSize bytes
+     * \return true if the buffers are valid
+     *
+     * \note Must be called before \ref initializeVideo. The buffers are owned by the application and must remain
+     * valid until the VideoCapture object is destroyed. Page aligned buffers are recommended.
+     * If no buffer is registered the library allocates them (see \ref VideoParams::use_hugepages and
+     * \ref VideoParams::lock_memory).
+     */
+    bool registerUserBuffers( const std::vector<void*>& buffers, size_t length );
+
+    /*!
+     * \brief Get the size of the buffers required to grab frames at the given resolution
+     * \param res the camera resolution
+     * \return the size of a YUV 4:2:2 side-by-side frame in bytes
+     */
+    static size_t getRequiredBufferSize( RESOLUTION res );
+
     /*!
      * \brief Get the last received camera image
      * \param timeout_msec frame grabbing timeout in millisecond.
+     * \param timed_out if not null, set to true if no new frame has been received before the timeout
      * \return returns a reference to the last received frame as pointer.
      *
-     * \note To check if a new frame is available it is possible to compare the timestamp of the returned frame with
-     * the timestamp of the previous valid frame
+     * \note If no new frame is received before the timeout the previous frame is returned. Use `timed_out`
+     * or compare the timestamp of the returned frame with the timestamp of the previous valid frame to detect it.
      *
      * \note Frame received will contains the RAW buffer from the camera, in YUV4:2:2 color format and in side by side mode.
      * Images must then be converted to RGB for proper display and will not be rectified.
+     * With \ref OUTPUT_FORMAT::GRAY the frame contains only the luma of the side by side images (`channels` is 1).
+     */
+    const Frame& getLastFrame(uint64_t timeout_msec=10, bool* timed_out=nullptr);
+
+    /*!
+     * \brief Get the last received camera image without copying it
+     * \param timeout_msec frame grabbing timeout in millisecond.
+     * \return returns a lease on the UVC buffer containing the last received frame. The lease is not valid if no new
+     * frame has been received before the timeout.
+     *
+     * \note The leased frame is always in YUV4:2:2 color format, whatever \ref VideoParams::output_format. The UVC
+     * buffer is queued again for grabbing only when the lease is released.
+     */
+    FrameLease leaseLastFrame(uint64_t timeout_msec=10);
+
+    /*!
+     * \brief Get the oldest frame not yet retrieved without copying it
+     * \param timeout_msec frame grabbing timeout in millisecond.
+     * \return returns a lease on the UVC buffer containing the frame. The lease is not valid if no new frame has
+     * been received before the timeout.
+     *
+     * \note Use this function with the \ref RING_POLICY::LOSSLESS policy to retrieve all the grabbed frames in order.
+     * Frames are lost only if the frame ring is full (see \ref CaptureStats::ring_overruns).
+     */
+    FrameLease leaseNextFrame(uint64_t timeout_msec=10);
+
+    /*!
+     * \brief Wait for the first frame following the given frame ID
+     * \param after_frame_id the ID of the last frame already processed, use `0` to get the first available frame
+     * \param deadline the steady clock time in nanoseconds (see \ref getSteadyTimestamp) when the wait times out
+     * \return returns a lease on the frame with the lowest ID greater than `after_frame_id`. The lease is not valid
+     * if the deadline expired or the capture has been stopped.
+     *
+     * \note The frames preceding the returned frame are removed from the frame ring.
+     * Frame ID continuity can be checked to detect lost frames.
+     */
+    FrameLease waitForFrame(uint64_t after_frame_id, uint64_t deadline);
+
+    /*!
+     * \brief Find the frame of the frame history closest to the given timestamp
+     * \param timestamp the timestamp in nanoseconds
+     * \param max_distance the maximum distance in nanoseconds from `timestamp`, `0` for no limit
+     * \return returns a lease on the found frame. The lease is not valid if the history is empty or disabled
+     * (see \ref VideoParams::history_depth) or no frame is close enough.
+     *
+     * \note The frame cannot be overwritten in the frame history until the lease is released.
+     */
+    FrameLease findFrameByTimestamp(uint64_t timestamp, uint64_t max_distance=0);
+
+    /*!
+     * \brief Find a frame of the frame history by ID
+     * \param frame_id the ID of the frame
+     * \return returns a lease on the found frame. The lease is not valid if the frame is not in the frame history.
+     *
+     * \note The frame cannot be overwritten in the frame history until the lease is released.
+     */
+    FrameLease findFrameById(uint64_t frame_id);
+
+    /*!
+     * \brief Register a callback to receive the grabbed frames
+     * \param callback the function called for each delivered frame
+     * \param options the subscriber options (see \ref SubscriberOptions)
+     * \return the ID of the subscriber, or `-1` if the callback is not valid
+     *
+     * \note Each subscriber runs its callback in a dedicated thread, so a slow subscriber does not stall the grabbing
+     * thread nor the other subscribers: frames arriving while its queue is full are dropped for that subscriber only.
+     * Subscribers receive the frames independently of the frame ring and of the other subscribers.
+     *
+     * \note Delivered leases hold UVC buffers: a slow subscriber with a deep queue reduces the buffers available for
+     * grabbing (see \ref VideoParams::buffer_count).
      */
-    const Frame& getLastFrame(uint64_t timeout_msec=10);
+    int subscribe(FrameCallback callback, SubscriberOptions options = SubscriberOptions());
+
+    /*!
+     * \brief Remove a subscriber. Frames waiting in its queue are dropped.
+     * \param id the ID returned by \ref subscribe
+     * \return true if the subscriber has been removed
+     */
+    bool unsubscribe(int id);
+
+    /*!
+     * \brief Get the statistics of a subscriber
+     * \param id the ID returned by \ref subscribe
+     * \param stats the returned statistics
+     * \return true if the subscriber exists
+     */
+    bool getSubscriberStats(int id, SubscriberStats& stats);
+
+    /*!
+     * \brief Get the frame grabbing statistics
+     * \return the current statistics
+     */
+    CaptureStats getCaptureStats();
 
     /*!
      * \brief Get the size of the camera frame
@@ -299,8 +608,105 @@ public:
      * \return the current Exposure value
      */
     int getExposure(CAM_SENS_POS cam);
+
+    /*!
+     * \brief Set the same Gain value on both the sensors with a single register transaction
+     * (disable Exposure and Gain control if active)
+     * \param gain Gain value in the range [0,100]
+     * \return returns a negative value if an error occurred
+     */
+    int setStereoGain(int gain);
+
+    /*!
+     * \brief Set the same Exposure value on both the sensors with a single register transaction
+     * (disable Exposure and Gain control if active)
+     * \param exposure Exposure value in the range [0,100]
+     * \return returns a negative value if an error occurred
+     */
+    int setStereoExposure(int exposure);
+
+    /*!
+     * \brief Invalidate the cached values of the camera controls written by the library (Exposure and Gain control
+     * status, Gain, Exposure, Gamma and LED status). The next get functions read the values from the camera.
+     *
+     * \note The get functions return the value written or read last, without USB transfers. Gain and Exposure are
+     * cached only while the automatic Exposure and Gain control is disabled, unless the background refresh is
+     * enabled (see \ref setControlCacheRefresh). Call this function if the camera is controlled by another process.
+     */
+    void invalidateControlCache();
+
+    /*!
+     * \brief Capture the current camera settings
+     * \return the current camera settings
+     */
+    CameraSettingsProfile getSettingsProfile();
+
+    /*!
+     * \brief Get the default camera settings, applied when the camera is opened
+     * \return the default camera settings
+     */
+    CameraSettingsProfile getDefaultSettingsProfile();
+
+    /*!
+     * \brief Apply a set of camera settings. The UVC controls are set with a single `VIDIOC_S_EXT_CTRLS` call.
+     * \param profile the camera settings
+     * \return returns a negative value if an error occurred
+     */
+    int applySettingsProfile(const CameraSettingsProfile& profile);
+
+    /*!
+     * \brief Enable the periodic refresh of the cached camera control values in background
+     * \param period_msec the refresh period in milliseconds, `0` to disable the refresh
+     *
+     * \note The refresh uses the asynchronous control thread, so it is delayed by the pending control commands.
+     */
+    void setControlCacheRefresh(uint64_t period_msec);
     // <---- Camera Settings control
 
+    // ----> Asynchronous Camera Settings control
+    /*!
+     * \brief Set the Exposure value without waiting for the USB control transfers (see \ref setExposure)
+     * \param cam position of the camera sensor (see  CAM_SENS_POS)
+     * \param exposure Exposure value in the range [0,100]
+     * \return a future returning `0` when the value has been written and verified, not `0` on failure
+     *
+     * \note The asynchronous commands are executed in order by a dedicated thread. A command still waiting in
+     * the queue is replaced by a new command setting the same control: the futures of both commands return the
+     * result of the latest one.
+     */
+    std::future<int> setExposureAsync(CAM_SENS_POS cam, int exposure);
+
+    /*!
+     * \brief Set the Gain value without waiting for the USB control transfers (see \ref setGain)
+     * \param cam position of the camera sensor (see  CAM_SENS_POS)
+     * \param gain Gain value in the range [0,100]
+     * \return a future returning `0` when the value has been written and verified, not `0` on failure
+     */
+    std::future<int> setGainAsync(CAM_SENS_POS cam, int gain);
+
+    /*!
+     * \brief Set the Gamma value without waiting for the USB control transfers (see \ref setGamma)
+     * \param gamma Gamma value in the range [1,9]
+     * \return a future returning `0` when the value has been written, not `0` on failure
+     */
+    std::future<int> setGammaAsync(int gamma);
+
+    /*!
+     * \brief Enable/Disable the automatic Exposure and Gain control without waiting for the USB control transfers
+     * (see \ref setAECAGC)
+     * \param active true to activate automatic Exposure and Gain control
+     * \return a future returning the result of \ref setAECAGC
+     */
+    std::future<int> setAECAGCAsync(bool active);
+
+    /*!
+     * \brief Set the status of the camera led without waiting for the USB control transfers (see \ref setLEDstatus)
+     * \param status true for "ON", false for "OFF"
+     * \return a future returning the result of \ref setLEDstatus
+     */
+    std::future<int> setLEDstatusAsync(bool status);
+    // <---- Asynchronous Camera Settings control
+
     /*!
      * \brief Retrieve the serial number of the connected camera
      * \return the serial number of the connected camera
@@ -323,7 +729,86 @@ public:
 #endif
 
 private:
+    friend class FrameLease;
+    friend class CameraRig;
+
     void grabThreadFunc();  //!< The frame grabbing thread function
+    void wakeGrabThread();  //!< Wake up the frame grabbing thread to process a control event
+    void grabFrames(uint64_t wake_ts, std::vector<std::pair<uint64_t,uint64_t>>* clock_samples=nullptr); //!< Dequeue all the available UVC buffers, optionally collecting the frame and arrival timestamps of the complete frames
+    uint64_t publishBuffer(int index, uint64_t ts_uvc, uint64_t arrival_ts); //!< Add a grabbed UVC buffer to the frame ring, returns the frame timestamp
+
+    // ----> Buffer management
+    void releaseBuffer(int index);          //!< Release a reference to a UVC buffer, queue it again if not referenced
+    void releaseBufferLocked(int index);    //!< As \ref releaseBuffer, `mBufMutex` must be locked by the caller
+    int takeBuffer(std::chrono::steady_clock::time_point deadline, uint64_t after_frame_id, bool oldest); //!< Wait for a new frame and take the reference to its buffer
+    bool ringHasFrameAfterLocked(uint64_t frame_id);  //!< Check if the frame ring contains a frame following `frame_id`, `mBufMutex` must be locked
+    void pushRingLocked(int index);         //!< Add a grabbed buffer to the frame ring, `mBufMutex` must be locked
+    int popRingLocked();                    //!< Remove the oldest buffer from the frame ring, `mBufMutex` must be locked
+    bool queueBuffer(int index);            //!< Queue a UVC buffer to the driver
+    void updateGrabStatsLocked(uint32_t sequence, uint64_t dequeue_ts); //!< Update the statistics for a dequeued buffer, `mBufMutex` must be locked
+    void updateLatencyStatsLocked(uint64_t latency); //!< Update the wakeup-to-dequeue latency statistics, `mBufMutex` must be locked
+    // <---- Buffer management
+
+    // ----> Subscribers
+    struct Subscriber;
+    void subscriberThreadFunc(std::shared_ptr<Subscriber> sub); //!< The subscriber callback thread function
+    void flushSubscribers();                //!< Drop the queued frames and wait for the running callbacks
+    // <---- Subscribers
+
+    // ----> Frame history
+    void createHistory();                   //!< Allocate the frame history slots
+    void storeHistory(int index);           //!< Copy a grabbed UVC buffer in the frame history
+    void copyFrameData(const Frame& src, size_t src_length, uint8_t* dst, FramePyramid* pyramid); //!< Copy a grabbed frame in the output format, luma extraction and pyramid included
+    size_t getOutputFrameSize();            //!< Size in bytes of a frame in the output format
+    int getPyramidLevels();                 //!< Number of pyramid levels allowed by the parameters and the resolution
+    size_t getPyramidSize();                //!< Size in bytes of the pyramid of a frame
+    void allocatePyramid(FramePyramid& pyramid); //!< Allocate the levels of a frame pyramid
+    void releaseHistorySlot(int slot);      //!< Release a reference to a frame history slot
+    FrameLease leaseHistoryLocked(size_t pos); //!< Lease the frame at the given position of the history, `mHistMutex` must be locked
+    // <---- Frame history
+
+    // ----> Asynchronous control
+    /*!
+     * \brief A camera control command waiting to be executed
+     */
+    struct ControlCommand {
+        uint32_t key;                           //!< Identifies the control set by the command, used to coalesce the commands
+        std::function<int()> action;            //!< The command
+        std::vector<std::promise<int>> promises;//!< The promises of the command and of the commands it replaced
+    };
+
+    std::future<int> submitControl(uint32_t key, std::function<int()> action); //!< Add a command to the control queue
+    void controlThreadFunc();               //!< The control thread function
+    void stopControlThread();               //!< Stop the control thread, the pending commands fail
+    void resumeControlThread();             //!< Accept the commands again after \ref stopControlThread, restarting the background refresh if enabled
+    void startControlThreadLocked();        //!< Start the control thread if not running, `mControlMutex` must be locked
+    // <---- Asynchronous control
+
+    // ----> Control cache
+    /*!
+     * \brief Cached values of the camera controls written by the library
+     */
+    struct ControlCache {
+        bool aecagcValid = false;           //!< Indicates if `aecagc` is valid
+        bool aecagc = false;                //!< Status of the automatic Exposure and Gain control
+        bool gainValid[2] = {false,false};  //!< Indicates if `gain` is valid for each sensor
+        int gain[2] = {0,0};                //!< Gain of each sensor
+        bool exposureValid[2] = {false,false}; //!< Indicates if `exposure` is valid for each sensor
+        int exposure[2] = {0,0};            //!< Exposure of each sensor
+        bool gammaValid = false;            //!< Indicates if `gamma` is valid
+        int gamma = 0;                      //!< Gamma value
+        bool ledValid = false;              //!< Indicates if `led` is valid
+        bool led = false;                   //!< LED status
+    };
+
+    void refreshControlCache();             //!< Read all the cached controls from the camera
+    int readGain(CAM_SENS_POS cam);         //!< Read the Gain value from the camera
+    int readExposure(CAM_SENS_POS cam);     //!< Read the Exposure value from the camera
+    int readAECAGC();                       //!< Read the status of the automatic Exposure and Gain control, negative if an error occurred
+    // <---- Control cache
+
+    bool createUserBuffers(unsigned int count, size_t size); //!< Set the buffers used with \ref BUFFER_MEMORY::USERPTR
+    void initV4l2Buffer(::v4l2_buffer& buf, int index); //!< Fill the memory fields of a V4L2 buffer
 
     // ----> Low level functions
     int ll_VendorControl(uint8_t *buf, int len, int readMode, bool safe = false);
@@ -337,6 +822,23 @@ private:
 
     int ll_SPI_FlashProgramRead(uint8_t *pBuf, int Adr, int len);
 
+    /*!
+     * \brief A block of consecutive sensor registers written by \ref ll_sensor_transaction
+     */
+    struct SensorRegBlock {
+        int side;                       //!< The sensor
+        uint64_t address;               //!< Address of the first register
+        std::vector<uint8_t> values;    //!< Values of the consecutive registers
+    };
+
+    int ll_read_system_registers(uint64_t address, uint8_t* values, int count);
+    int ll_write_system_registers(uint64_t address, const uint8_t* values, int count);
+    int ll_read_sensor_registers(int side, int sscb_id, uint64_t address, uint8_t* values, int count);
+    int ll_write_sensor_registers(int side, int sscb_id, uint64_t address, const uint8_t* values, int count);
+    int ll_sensor_transaction(const std::vector<SensorRegBlock>& blocks, bool verify);
+    int ll_sensor_transaction_locked(const std::vector<SensorRegBlock>& blocks, bool verify);
+    bool ll_probe_sensor_burst(); //!< Enable the multi-register sensor transfers if a burst read matches the single register reads
+
     int ll_isp_aecagc_enable(int side, bool enable);
     int ll_isp_is_aecagc(int side);
 
@@ -349,12 +851,28 @@ private:
     // <---- Low level functions
 
     // ----> Mid level functions
+    /*!
+     * \brief The range of a UVC control
+     */
+    struct ControlRange {
+        int min = 0;                    //!< Minimum value
+        int max = 0;                    //!< Maximum value
+        int def = 0;                    //!< Default value
+        bool valid = false;             //!< Indicates if the control has been queried successfully
+    };
+
+    ControlRange getControlRange(int ctrl_id); //!< Get the range of a UVC control, queried only once
+
     void setCameraControlSettings(int ctrl_id, int ctrl_val);
     void resetCameraControlSettings(int ctrl_id);
     int getCameraControlSettings(int ctrl_id);
 
     int setGammaPreset(int side, int value);
 
+    int writeGamma(int gamma);                      //!< Set the Gamma value, returns the result of the XU writes
+    int writeGain(CAM_SENS_POS cam, int gain);      //!< Set the Gain value, returns the result of the verified register writes
+    int writeExposure(CAM_SENS_POS cam, int exposure); //!< Set the Exposure value, returns the result of the verified register writes
+
     int calcRawGainValue(int gain); // Convert "user gain" to "ISP gain"
     int calcGainValue(int rawGain); // Convert "ISP Gain" to "User gain"
     // <---- Mid level functions
@@ -372,19 +890,25 @@ private:
 
 private:
     // Flags
-    bool mNewFrame=false;               //!< Indicates if a new frame is available
-    bool mInitialized=false;            //!< Inficates if the camera has been initialized
-    bool mStopCapture=true;             //!< Indicates if the grabbing thread must be stopped
+    std::atomic<bool> mInitialized{false}; //!< Inficates if the camera has been initialized
+    std::atomic<bool> mStopCapture{true}; //!< Indicates if the grabbing thread must be stopped
     bool mGrabRunning=false;            //!< Indicates if the grabbing thread is running
+    bool mExternalGrab=false;           //!< The UVC buffers are dequeued by an external thread (see \ref CameraRig) instead of the grabbing thread
 
     VideoParams mParams;                //!< Grabbing parameters
 
     int mDevId = 0;                     //!< ID of the camera device
+    int mSerialNumber = -1;             //!< Serial number of the camera, `-1` if not yet retrieved
     std::string mDevName;               //!< The file descriptor path name (e.g. /dev/video0)
     int mFileDesc=-1;                   //!< The file descriptor handler
+    int mEventFd=-1;                    //!< Event used to wake up the grabbing thread
 
     std::mutex mBufMutex;               //!< Mutex for safe access to data buffer
-    std::mutex mComMutex;               //!< Mutex for safe access to UVC communication
+    std::condition_variable mFrameCond; //!< Signals new frames in the frame ring, used with `mBufMutex`
+    std::mutex mComMutex;               //!< Mutex for safe access to the UVC control channel, not used by the streaming ioctls
+    std::mutex mRegMutex;               //!< Serializes the register transactions made of several control transfers
+    std::atomic<bool> mSensorBurst{false}; //!< Indicates if the firmware supports multi-register sensor transfers, set by \ref ll_probe_sensor_burst
+    std::atomic<bool> mSystemBurst{true}; //!< Indicates if the firmware supports multi-register system transfers
 
     int mWidth = 0;                     //!< Frame width
     int mHeight = 0;                    //!< Frame height
@@ -394,9 +918,57 @@ private:
     SL_DEVICE mCameraModel = SL_DEVICE::NONE; //!< The camera model
 
     Frame mLastFrame;                   //!< Last grabbed frame
-    uint8_t mBufCount = 2;              //!< UVC buffer count
-    uint8_t mCurrentIndex = 0;          //!< The index of the currect UVC buffer
+    FramePyramid mLastPyramid;          //!< Pyramid of the last grabbed frame
+    uint64_t mFrameIdCount = 0;         //!< Counter used to assign the frame IDs
+    uint8_t mBufCount = 4;              //!< UVC buffer count (leased buffers are not available for grabbing)
     struct UVCBuffer *mBuffers = nullptr;  //!< UVC buffers
+    BUFFER_MEMORY mBufMemory = BUFFER_MEMORY::MMAP; //!< Memory used for the UVC buffers
+    bool mOwnUserBuffers = false;       //!< Indicates if the USERPTR buffers have been allocated by the library
+    std::vector<void*> mUserBuffers;    //!< USERPTR buffers registered by the application
+    size_t mUserBufferLength = 0;       //!< Size of the USERPTR buffers registered by the application
+    size_t mFrameSize = 0;              //!< Size of a complete frame negotiated with the driver (`sizeimage`)
+    std::vector<Frame> mBufFrames;      //!< Frame information for each UVC buffer
+    std::vector<int> mBufRefCount;      //!< Number of references to each UVC buffer, it's queued again when zero
+
+    std::vector<int> mRing;             //!< Frame ring with the indices of the buffers not yet retrieved
+    size_t mRingHead = 0;               //!< Position of the oldest frame in the ring
+    size_t mRingCount = 0;              //!< Number of frames in the ring
+
+    /*!
+     * \brief A frame copied in the frame history
+     */
+    struct HistorySlot {
+        Frame frame;                        //!< The frame information
+        std::unique_ptr<uint8_t[]> data;    //!< The frame data
+        FramePyramid pyramid;               //!< The frame pyramid
+        int refCount = 0;                   //!< Number of leases referring to the slot
+    };
+
+    std::vector<HistorySlot> mHistorySlots; //!< Frame history storage
+    std::deque<int> mHistory;           //!< Slots of the frame history sorted by frame ID (and timestamp)
+    std::vector<int> mHistoryFree;      //!< Slots not used by the frame history
+    std::mutex mHistMutex;              //!< Mutex for safe access to the frame history
+
+    std::thread mControlThread;         //!< The thread executing the asynchronous control commands
+    std::mutex mControlMutex;           //!< Mutex for safe access to the control queue
+    std::condition_variable mControlCond; //!< Signals new control commands
+    std::deque<ControlCommand> mControlQueue; //!< The control commands waiting to be executed
+    bool mControlStop = false;          //!< Indicates if the control thread must be stopped, the commands are rejected until \ref resumeControlThread
+
+    ControlCache mCtrlCache;            //!< Cached values of the camera controls
+    std::mutex mCacheMutex;             //!< Mutex for safe access to the control cache
+    std::atomic<uint64_t> mCacheRefreshMsec{0}; //!< Period of the control cache background refresh, `0` if disabled
+
+    std::map<int,ControlRange> mCtrlRanges; //!< Cache of the UVC control ranges
+    std::mutex mRangeMutex;             //!< Mutex for safe access to the control ranges
+
+    std::map<int,std::shared_ptr<Subscriber>> mSubscribers; //!< The frame subscribers
+    std::mutex mSubMutex;               //!< Mutex for safe access to the subscribers
+    int mNextSubId = 1;                 //!< ID of the next subscriber
+
+    CaptureStats mStats;                //!< Frame grabbing statistics
+    uint32_t mLastSequence = 0;         //!< V4L2 sequence number of the last dequeued buffer
+    uint64_t mLastDequeueTs = 0;        //!< Steady timestamp of the last dequeued buffer [nsec]
 
     uint64_t mStartTs=0;                //!< Initial System Timestamp, to calculate differences [nsec]
     uint64_t mInitTs=0;                 //!< Initial Device Timestamp, to calculate differences [usec]
@@ -74,6 +74,38 @@ enum class CAM_SENS_POS {
     LAST = 3
 };
 
+/*!
+ * \brief Policies used to deliver the grabbed frames
+ */
+enum class RING_POLICY {
+    LATEST,     //!< Only the freshest frame is kept, stale frames are discarded to get the lowest latency
+    LOSSLESS    //!< All the frames are kept in order until the frame ring is full
+};
+
+/*!
+ * \brief Memory used for the UVC buffers
+ */
+enum class BUFFER_MEMORY {
+    MMAP,       //!< Buffers allocated by the driver and mapped in the process memory
+    USERPTR     //!< Buffers allocated in the process memory, by the application (see \ref VideoCapture::registerUserBuffers) or by the library
+};
+
+/*!
+ * \brief Format of the frames copied by the library (see \ref VideoCapture::getLastFrame and the frame history)
+ */
+enum class OUTPUT_FORMAT {
+    YUYV,       //!< Side by side YUV 4:2:2, 2 bytes per pixel, as grabbed
+    GRAY        //!< Side by side 8 bit luma, 1 byte per pixel, extracted while copying the frame
+};
+
+/*!
+ * \brief Format of the levels of the frame pyramid (see \ref VideoParams::pyramid_levels)
+ */
+enum class PYRAMID_FORMAT {
+    GRAY,       //!< 8 bit luma, 1 byte per pixel
+    BGR         //!< Packed 8 bit BGR, 3 bytes per pixel
+};
+
 /*!
  * \brief The camera configuration parameters
  */
@@ -86,13 +118,55 @@ typedef struct VideoParams
         res = RESOLUTION::HD2K;
         fps = FPS::FPS_15;
         verbose= sl_oc::VERBOSITY::ERROR;
+        buffer_count = 4;
+        ring_policy = RING_POLICY::LATEST;
+        export_dmabuf = false;
+        buffer_memory = BUFFER_MEMORY::MMAP;
+        use_hugepages = false;
+        lock_memory = false;
+        history_depth = 0;
+        history_max_bytes = 0;
+        output_format = OUTPUT_FORMAT::YUYV;
+        pyramid_levels = 0;
+        pyramid_format = PYRAMID_FORMAT::GRAY;
     }
 
     RESOLUTION res; //!< Camera resolution
     FPS fps;        //!< Frames per second
     int verbose;   //!< Verbose mode
+    uint8_t buffer_count;       //!< Number of UVC buffers requested to the driver, in the range [2,32]
+    RING_POLICY ring_policy;    //!< Frame delivery policy (see \ref RING_POLICY)
+    bool export_dmabuf;         //!< Export each UVC buffer as a DMABUF file descriptor (see \ref Frame::dmabuf_fd). Only with \ref BUFFER_MEMORY::MMAP
+    BUFFER_MEMORY buffer_memory;//!< Memory used for the UVC buffers (see \ref BUFFER_MEMORY)
+    bool use_hugepages;         //!< Back the buffers allocated by the library with 2 MB hugepages. Only with \ref BUFFER_MEMORY::USERPTR
+    bool lock_memory;           //!< Lock the buffers allocated by the library in RAM. Only with \ref BUFFER_MEMORY::USERPTR
+    uint16_t history_depth;     //!< Number of recent frames copied in the frame history, `0` to disable it (see \ref VideoCapture::findFrameByTimestamp)
+    size_t history_max_bytes;   //!< Memory budget of the frame history in bytes, it limits \ref history_depth. `0` for no limit
+    OUTPUT_FORMAT output_format;//!< Format of the frames copied by the library (see \ref OUTPUT_FORMAT). Leased UVC buffers are always YUYV
+    uint8_t pyramid_levels;     //!< Number of levels of the per eye image pyramid built while copying the frames, `0` to disable it, at most `6` (see \ref Frame::pyramid)
+    PYRAMID_FORMAT pyramid_format;//!< Format of the pyramid levels
 } VideoParams;
 
+/*!
+ * \brief Frame grabbing statistics
+ */
+struct CaptureStats {
+    uint64_t grabbed_frames = 0;    //!< Number of frames dequeued from the driver
+    uint64_t driver_drops = 0;      //!< Number of frames lost by the driver (e.g. no UVC buffer was available)
+    uint64_t stale_drops = 0;       //!< Number of stale frames discarded by the \ref RING_POLICY::LATEST policy
+    uint64_t ring_overruns = 0;     //!< Number of frames overwritten in the frame ring before being retrieved
+    uint64_t history_drops = 0;     //!< Number of frames not stored in the frame history because all its frames were leased
+
+    uint64_t wakeups = 0;               //!< Number of grabbing thread wakeups with available frames
+    uint64_t dequeue_latency_last = 0;  //!< Wakeup-to-dequeue latency of the last wakeup [nsec]
+    uint64_t dequeue_latency_max = 0;   //!< Maximum wakeup-to-dequeue latency [nsec]
+    double dequeue_latency_avg = 0.0;   //!< Average wakeup-to-dequeue latency [nsec]
+
+    uint64_t dequeue_interval_last = 0; //!< Time between the last two dequeued frames [nsec]
+    uint64_t dequeue_jitter_max = 0;    //!< Maximum deviation of the dequeue interval from the frame period [nsec]
+    double dequeue_jitter_avg = 0.0;    //!< Average deviation of the dequeue interval from the frame period [nsec]
+};
+
 /*!
  * \brief Resolution in pixel for each frame
  */
@@ -127,6 +201,7 @@ static const std::vector<Resolution> cameraResolution = {
 struct UVCBuffer {
     void *start;    //!< Address of the first byte of the buffer
     size_t length;  //!< Size of the buffer
+    int dmabuf_fd;  //!< DMABUF file descriptor exported for the buffer, -1 if not exported
 };
 
 
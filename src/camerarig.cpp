@@ -0,0 +1,522 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include "camerarig.hpp"
+
+#ifdef SENSORS_MOD_AVAILABLE
+#include "sensorcapture.hpp"
+#endif
+
+#include <unistd.h>           // for close, read, write
+#include <string.h>           // for memset, strerror
+#include <errno.h>            // for errno, EINTR
+#include <sys/epoll.h>        // for epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>      // for eventfd
+
+#include <algorithm>
+
+namespace sl_oc {
+
+namespace video {
+
+// Epoll user data of the stop events
+static const uint64_t IO_STOP_EVENT = UINT64_MAX;
+
+/*!
+ * \brief A camera of the rig with its grabbing state
+ */
+struct CameraRig::RigCamera
+{
+    std::unique_ptr<VideoCapture> video;            //!< The video capture
+#ifdef SENSORS_MOD_AVAILABLE
+    std::unique_ptr<sensors::SensorCapture> sensors;//!< The sensors capture, if opened
+#endif
+    int serial_number = -1;                         //!< Serial number of the camera
+    int video_id = -1;                              //!< ID of the video device
+    bool opened = false;                            //!< Indicates if the camera has been opened
+
+    std::atomic<bool> error{false};                 //!< A streaming error occurred, the camera is not polled anymore
+    std::atomic<uint64_t> last_grab_ts{0};          //!< Steady timestamp of the last grabbed frames
+
+    uint64_t last_frame_id = 0;                     //!< ID of the newest frame used for a frame set
+    uint64_t frame_sets = 0;                        //!< Number of frame sets including a frame of the camera
+    uint64_t sync_misses = 0;                       //!< Number of frame sets without a frame of the camera
+};
+
+bool FrameSet::isComplete() const
+{
+    for( const FrameLease& lease : frames )
+    {
+        if( !lease.isValid() )
+            return false;
+    }
+
+    return !frames.empty();
+}
+
+CameraRig::CameraRig( const RigParams& params )
+{
+    mParams = params;
+
+    if( mParams.io_threads==0 )
+        mParams.io_threads = 1;
+
+    mFramePeriod = NSEC_PER_SEC/static_cast<uint64_t>(mParams.video.fps);
+}
+
+CameraRig::~CameraRig()
+{
+    close();
+}
+
+bool CameraRig::open()
+{
+    close();
+
+    // ----> Cameras to open, sorted by serial number
+    std::vector<VideoDeviceInfo> devs = VideoCapture::enumerate();
+    for( int sn : mParams.serials )
+    {
+        // A camera connected after the last scan requires a new scan
+        if( std::none_of( devs.begin(), devs.end(), [sn](const VideoDeviceInfo& dev) {return dev.serial_number==sn;} ) )
+        {
+            devs = VideoCapture::enumerate( true );
+            break;
+        }
+    }
+    std::sort( devs.begin(), devs.end(), [](const VideoDeviceInfo& a, const VideoDeviceInfo& b) {
+        return a.serial_number < b.serial_number;
+    });
+
+    bool all_found = true;
+    std::vector<VideoDeviceInfo> selected;
+    if( mParams.serials.empty() )
+    {
+        selected = devs;
+    }
+    else
+    {
+        for( int sn : mParams.serials )
+        {
+            std::vector<VideoDeviceInfo>::iterator it = std::find_if( devs.begin(), devs.end(),
+                                                                      [sn](const VideoDeviceInfo& dev) {
+                return dev.serial_number==sn;
+            });
+
+            if( it==devs.end() )
+            {
+                std::string msg = "Camera with serial number " + std::to_string(sn) + " not found";
+                ERROR_OUT(mParams.video.verbose,msg);
+                all_found = false;
+                continue;
+            }
+
+            selected.push_back(*it);
+        }
+    }
+    // <---- Cameras to open, sorted by serial number
+
+    // ----> Open the cameras in parallel
+    std::vector<std::unique_ptr<RigCamera>> cameras;
+    for( size_t i=0; i<selected.size(); i++ )
+        cameras.push_back( std::unique_ptr<RigCamera>(new RigCamera()) );
+
+    std::vector<std::thread> openThreads;
+    for( size_t i=0; i<selected.size(); i++ )
+    {
+        openThreads.push_back( std::thread( [this,&cameras,&selected,i]() {
+            cameras[i]->opened = openCamera( *cameras[i], selected[i].id, selected[i].serial_number );
+        }));
+    }
+
+    for( std::thread& th : openThreads )
+        th.join();
+    // <---- Open the cameras in parallel
+
+#ifdef SENSORS_MOD_AVAILABLE
+    // ----> Open the sensors one by one: hidapi initialization and enumeration are not thread safe
+    if( mParams.open_sensors )
+    {
+        if( hid_init()!=0 )
+        {
+            WARNING_OUT(mParams.video.verbose,"Cannot initialize hidapi, the sensors are not available");
+        }
+        else
+        {
+            for( std::unique_ptr<RigCamera>& cam : cameras )
+            {
+                if( cam->opened )
+                    openSensors( *cam );
+            }
+        }
+    }
+    // <---- Open the sensors one by one: hidapi initialization and enumeration are not thread safe
+#endif
+
+    bool all_opened = all_found;
+    for( std::unique_ptr<RigCamera>& cam : cameras )
+    {
+        if( cam->opened )
+        {
+            mCameras.push_back( std::move(cam) );
+        }
+        else
+        {
+            std::string msg = "Cannot open the camera on /dev/video" + std::to_string(cam->video_id);
+            ERROR_OUT(mParams.video.verbose,msg);
+            all_opened = false;
+        }
+    }
+
+    if( mCameras.empty() )
+    {
+        ERROR_OUT(mParams.video.verbose,"No camera opened");
+        return false;
+    }
+
+    // ----> Start the grabbing threads
+    size_t threadCount = std::min( static_cast<size_t>(mParams.io_threads), mCameras.size() );
+
+    mStop = false;
+    for( size_t t=0; t<threadCount; t++ )
+    {
+        int fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+        if( fd == -1 )
+        {
+            std::string msg = std::string("Cannot create the rig grabbing event: ") + std::string(strerror(errno));
+            ERROR_OUT(mParams.video.verbose,msg);
+            close();
+            return false;
+        }
+        mIoEventFds.push_back(fd);
+    }
+
+    for( size_t t=0; t<threadCount; t++ )
+        mIoThreads.push_back( std::thread( &CameraRig::ioThreadFunc, this, t ) );
+    // <---- Start the grabbing threads
+
+    if( mParams.video.verbose )
+    {
+        std::string msg = "Camera rig opened with " + std::to_string(mCameras.size()) + " cameras and "
+                + std::to_string(threadCount) + " grabbing threads";
+        INFO_OUT(mParams.video.verbose,msg);
+    }
+
+    return all_opened;
+}
+
+bool CameraRig::openCamera( RigCamera& cam, int video_id, int sn )
+{
+    cam.video_id = video_id;
+
+    cam.video.reset( new VideoCapture(mParams.video) );
+    cam.video->mExternalGrab = true;
+
+    if( !cam.video->initializeVideo(video_id) )
+        return false;
+
+    cam.serial_number = (sn!=-1)?sn:cam.video->getSerialNumber();
+    cam.last_grab_ts = getSteadyTimestamp();
+
+    return true;
+}
+
+void CameraRig::openSensors( RigCamera& cam )
+{
+#ifdef SENSORS_MOD_AVAILABLE
+    cam.sensors.reset( new sensors::SensorCapture(static_cast<sl_oc::VERBOSITY>(mParams.video.verbose)) );
+    if( cam.sensors->initializeSensors(cam.serial_number) )
+    {
+        cam.video->enableSensorSync( cam.sensors.get() );
+    }
+    else
+    {
+        std::string msg = "Cannot open the sensors of the camera with serial number " + std::to_string(cam.serial_number);
+        WARNING_OUT(mParams.video.verbose,msg);
+        cam.sensors.reset();
+    }
+#else
+    (void)cam;
+#endif
+}
+
+void CameraRig::close()
+{
+    // ----> Stop the grabbing threads before closing the cameras they poll
+    mStop = true;
+    for( int fd : mIoEventFds )
+    {
+        uint64_t one = 1;
+        ssize_t res = write(fd, &one, sizeof(one));
+        (void)res;
+    }
+
+    for( std::thread& th : mIoThreads )
+    {
+        if( th.joinable() )
+            th.join();
+    }
+    mIoThreads.clear();
+
+    for( int fd : mIoEventFds )
+        ::close(fd);
+    mIoEventFds.clear();
+    // <---- Stop the grabbing threads before closing the cameras they poll
+
+    mCameras.clear();
+    mSetCount = 0;
+    mTimeService.reset();
+}
+
+VideoCapture* CameraRig::getCamera( size_t idx )
+{
+    if( idx>=mCameras.size() )
+        return nullptr;
+
+    return mCameras[idx]->video.get();
+}
+
+#ifdef SENSORS_MOD_AVAILABLE
+sensors::SensorCapture* CameraRig::getSensors( size_t idx )
+{
+    if( idx>=mCameras.size() )
+        return nullptr;
+
+    return mCameras[idx]->sensors.get();
+}
+#endif
+
+void CameraRig::ioThreadFunc( size_t thread_idx )
+{
+    size_t threadCount = mIoEventFds.size();
+
+    // ----> Wait for the video data of the cameras assigned to this thread
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if( epollFd == -1 )
+    {
+        std::string msg = std::string("Cannot create the rig grabbing epoll instance: ") + std::string(strerror(errno));
+        ERROR_OUT(mParams.video.verbose,msg);
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = IO_STOP_EVENT;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, mIoEventFds[thread_idx], &ev);
+
+    size_t polled = 0;
+    for( size_t i=thread_idx; i<mCameras.size(); i+=threadCount )
+    {
+        ev.data.u64 = i;
+        if( epoll_ctl(epollFd, EPOLL_CTL_ADD, mCameras[i]->video->mFileDesc, &ev)==0 )
+            polled++;
+    }
+    // <---- Wait for the video data of the cameras assigned to this thread
+
+    std::vector<struct epoll_event> events( polled+1 );
+    std::vector<std::pair<uint64_t,uint64_t>> clockSamples;
+
+    while( !mStop && polled>0 )
+    {
+        int n = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+        uint64_t wake_ts = getSteadyTimestamp();
+
+        if( n < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+
+            std::string msg = std::string("Rig grabbing wait failed: ") + std::string(strerror(errno));
+            ERROR_OUT(mParams.video.verbose,msg);
+            break;
+        }
+
+        for( int i=0; i<n && !mStop; i++ )
+        {
+            if( events[i].data.u64 == IO_STOP_EVENT )
+                continue;
+
+            size_t idx = static_cast<size_t>(events[i].data.u64);
+            RigCamera& cam = *mCameras[idx];
+
+            if( events[i].events & (EPOLLERR|EPOLLHUP) )
+            {
+                std::string msg = "Streaming error on camera " + std::to_string(cam.serial_number) + ". Grabbing stopped";
+                ERROR_OUT(mParams.video.verbose,msg);
+
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, cam.video->mFileDesc, nullptr);
+                cam.error = true;
+                polled--;
+            }
+            else if( events[i].events & EPOLLIN )
+            {
+                clockSamples.clear();
+                cam.video->grabFrames( wake_ts, &clockSamples );
+                cam.last_grab_ts = getSteadyTimestamp();
+
+                // Every grabbed frame updates the clock estimation, also the ones never consumed
+                for( const auto& sample : clockSamples )
+                    mTimeService.addSample( static_cast<int>(idx), sample.first, sample.second );
+            }
+        }
+    }
+
+    ::close(epollFd);
+}
+
+bool CameraRig::grabFrameSet( FrameSet& set, uint64_t timeout_msec )
+{
+    set.frames.clear();
+    set.host_timestamps.clear();
+    set.max_skew = 0;
+
+    if( mCameras.empty() )
+        return false;
+
+    uint64_t deadline = getSteadyTimestamp() + timeout_msec*1000000ULL;
+    uint64_t maxDist = (mParams.max_sync_distance!=0)?mParams.max_sync_distance:mFramePeriod/2;
+
+    // ----> Newest frame of each camera
+    set.frames.resize( mCameras.size() );
+    set.host_timestamps.resize( mCameras.size(), 0 );
+
+    bool found = false;
+    uint64_t ref_ts = UINT64_MAX;
+    for( size_t i=0; i<mCameras.size(); i++ )
+    {
+        RigCamera& cam = *mCameras[i];
+        if( cam.error )
+            continue;
+
+        set.frames[i] = cam.video->waitForFrame( cam.last_frame_id, deadline );
+        if( !set.frames[i].isValid() )
+            continue;
+
+        const Frame& frame = set.frames[i].frame();
+        cam.last_frame_id = frame.frame_id;
+
+        set.host_timestamps[i] = mTimeService.toHostTime( static_cast<int>(i), frame.timestamp );
+        ref_ts = std::min( ref_ts, set.host_timestamps[i] );
+        found = true;
+    }
+    // <---- Newest frame of each camera
+
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+
+    if( !found )
+    {
+        for( std::unique_ptr<RigCamera>& cam : mCameras )
+            cam->sync_misses++;
+
+        set.frames.clear();
+        set.host_timestamps.clear();
+        return false;
+    }
+
+    // ----> Align the frames on the oldest new frame, in the host clock domain
+    for( size_t i=0; i<mCameras.size(); i++ )
+    {
+        RigCamera& cam = *mCameras[i];
+        FrameLease& lease = set.frames[i];
+        uint64_t& host_ts = set.host_timestamps[i];
+
+        if( lease.isValid() && host_ts>ref_ts )
+        {
+            uint64_t dist = host_ts-ref_ts;
+
+            FrameLease past = cam.video->findFrameByTimestamp( mTimeService.toDeviceTime(static_cast<int>(i),ref_ts), dist );
+            if( past.isValid() )
+            {
+                uint64_t past_ts = mTimeService.toHostTime( static_cast<int>(i), past.frame().timestamp );
+                uint64_t past_dist = (past_ts>ref_ts)?(past_ts-ref_ts):(ref_ts-past_ts);
+                if( past_dist<dist )
+                {
+                    lease = std::move(past);
+                    host_ts = past_ts;
+                }
+            }
+        }
+
+        if( lease.isValid() )
+        {
+            uint64_t dist = (host_ts>ref_ts)?(host_ts-ref_ts):(ref_ts-host_ts);
+
+            if( dist>maxDist )
+            {
+                lease.release();
+                host_ts = 0;
+            }
+            else
+            {
+                set.max_skew = std::max( set.max_skew, dist );
+            }
+        }
+
+        if( lease.isValid() )
+            cam.frame_sets++;
+        else
+            cam.sync_misses++;
+    }
+    // <---- Align the frames on the oldest new frame, in the host clock domain
+
+    set.set_id = ++mSetCount;
+    set.timestamp = ref_ts;
+
+    return true;
+}
+
+uint64_t CameraRig::toHostTime( size_t idx, uint64_t timestamp )
+{
+    return mTimeService.toHostTime( static_cast<int>(idx), timestamp );
+}
+
+std::vector<RigCameraStats> CameraRig::getStats()
+{
+    std::vector<RigCameraStats> stats;
+    uint64_t now = getSteadyTimestamp();
+
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+
+    for( std::unique_ptr<RigCamera>& cam : mCameras )
+    {
+        RigCameraStats camStats;
+        camStats.serial_number = cam->serial_number;
+        camStats.video_id = cam->video_id;
+
+        uint64_t last = cam->last_grab_ts;
+        camStats.last_frame_age = (now>last)?(now-last):0;
+        camStats.healthy = !cam->error && camStats.last_frame_age<5*mFramePeriod;
+
+        camStats.frame_sets = cam->frame_sets;
+        camStats.sync_misses = cam->sync_misses;
+        camStats.capture = cam->video->getCaptureStats();
+        mTimeService.getEstimate( static_cast<int>(stats.size()), camStats.clock );
+
+        stats.push_back(camStats);
+    }
+
+    return stats;
+}
+
+}
+
+}
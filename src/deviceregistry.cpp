@@ -0,0 +1,342 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "deviceregistry.hpp"
+
+#include <dirent.h>           // for opendir, readdir
+#include <limits.h>           // for PATH_MAX
+#include <stdlib.h>           // for realpath
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+
+namespace sl_oc {
+
+// ----> sysfs helpers
+// Read the first line of a sysfs attribute
+static bool readAttr( const std::string& path, std::string& value )
+{
+    std::ifstream file(path);
+    return static_cast<bool>(std::getline(file, value));
+}
+
+// Read an hexadecimal sysfs attribute
+static bool readHexAttr( const std::string& path, uint16_t& value )
+{
+    std::string str;
+    if( !readAttr(path,str) )
+        return false;
+
+    unsigned int val = 0;
+    if( !(std::istringstream(str) >> std::hex >> val) )
+        return false;
+
+    value = static_cast<uint16_t>(val);
+    return true;
+}
+
+// Parse a serial number made only of decimal digits
+static int parseSerial( const std::string& str )
+{
+    if( str.empty() || str.size()>9 || str.find_first_not_of("0123456789")!=std::string::npos )
+        return -1;
+
+    return std::stoi(str);
+}
+
+// Serial number of a video node from the udev database, for the cameras not exposing it in sysfs
+static int udevSerial( const std::string& video_name )
+{
+    std::string devNum;
+    if( !readAttr("/sys/class/video4linux/"+video_name+"/dev", devNum) )
+        return -1;
+
+    std::ifstream udev("/run/udev/data/c" + devNum);
+    std::string line;
+    while( std::getline(udev,line) )
+    {
+        if( line.compare(0,18,"E:ID_SERIAL_SHORT=")==0 )
+            return parseSerial(line.substr(18));
+    }
+
+    return -1;
+}
+
+// Name of the USB device reached following `link` (e.g. 2-1.2)
+static std::string usbDeviceName( const std::string& link )
+{
+    char path[PATH_MAX];
+    if( realpath( link.c_str(), path )==nullptr )
+        return std::string();
+
+    std::string str = path;
+    return str.substr(str.find_last_of('/')+1);
+}
+
+// USB path of the hub the device is connected to (e.g. 2-1 for 2-1.2)
+static std::string usbParentName( const std::string& name )
+{
+    size_t pos = name.find_last_of('.');
+    if( pos==std::string::npos )
+        pos = name.find_last_of('-');
+    return name.substr(0,pos);
+}
+
+// List the entries of a directory starting with `prefix`
+static std::vector<std::string> listDir( const std::string& path, const std::string& prefix )
+{
+    std::vector<std::string> entries;
+
+    DIR* dir = opendir(path.c_str());
+    if( !dir )
+        return entries;
+
+    struct dirent* entry;
+    while( (entry=readdir(dir)) != nullptr )
+    {
+        std::string name = entry->d_name;
+        if( name.compare(0,prefix.size(),prefix)==0 && name!="." && name!=".." )
+            entries.push_back(name);
+    }
+
+    closedir(dir);
+    return entries;
+}
+// <---- sysfs helpers
+
+// ----> Models
+static bool isVideoPid( uint16_t pid )
+{
+    return pid==SL_USB_PROD_ZED_REVA || pid==SL_USB_PROD_ZED_M_REVA || pid==SL_USB_PROD_ZED_REVB ||
+            pid==SL_USB_PROD_ZED_M_REVB || pid==SL_USB_PROD_ZED_2_REVB;
+}
+
+static bool isMcuPid( uint16_t pid )
+{
+    return pid==SL_USB_PROD_MCU_ZEDM_REVA || pid==SL_USB_PROD_MCU_ZED2_REVA;
+}
+
+static std::string modelName( uint16_t pid )
+{
+    switch(pid)
+    {
+    case SL_USB_PROD_ZED_REVA:
+    case SL_USB_PROD_ZED_REVB:
+        return "ZED";
+    case SL_USB_PROD_ZED_M_REVA:
+    case SL_USB_PROD_ZED_M_REVB:
+    case SL_USB_PROD_MCU_ZEDM_REVA:
+        return "ZED Mini";
+    case SL_USB_PROD_ZED_2_REVB:
+    case SL_USB_PROD_MCU_ZED2_REVA:
+        return "ZED 2";
+    default:
+        return "Unknown";
+    }
+}
+// <---- Models
+
+DeviceRegistry& DeviceRegistry::instance()
+{
+    static DeviceRegistry registry;
+    return registry;
+}
+
+std::vector<CameraDevice> DeviceRegistry::getDevices( bool refresh )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    if( refresh || !mScanned )
+        scanLocked();
+
+    return mDevices;
+}
+
+bool DeviceRegistry::findBySerial( int sn, CameraDevice& dev )
+{
+    // A camera connected after the last scan requires a new scan
+    for( int attempt=0; attempt<2; attempt++ )
+    {
+        std::vector<CameraDevice> devs = getDevices( attempt>0 );
+        for( const CameraDevice& cur : devs )
+        {
+            if( cur.serial_number==sn )
+            {
+                dev = cur;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool DeviceRegistry::findByVideoId( int video_id, CameraDevice& dev )
+{
+    for( int attempt=0; attempt<2; attempt++ )
+    {
+        std::vector<CameraDevice> devs = getDevices( attempt>0 );
+        for( const CameraDevice& cur : devs )
+        {
+            if( cur.video_id==video_id )
+            {
+                dev = cur;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void DeviceRegistry::refresh()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    scanLocked();
+}
+
+void DeviceRegistry::scanLocked()
+{
+    mDevices.clear();
+    mScanned = true;
+
+    // ----> Video nodes and HID devices by USB device name
+    std::map<std::string,int> videoIds;
+    for( const std::string& name : listDir("/sys/class/video4linux","video") )
+    {
+        std::string index;
+        if( readAttr("/sys/class/video4linux/"+name+"/index", index) && index!="0" )
+            continue; // metadata node
+
+        std::string usbName = usbDeviceName("/sys/class/video4linux/"+name+"/device/..");
+        if( !usbName.empty() )
+            videoIds[usbName] = std::atoi(name.c_str()+5);
+    }
+
+    std::map<std::string,std::string> hidrawDevs;
+    for( const std::string& name : listDir("/sys/class/hidraw","hidraw") )
+    {
+        std::string usbName = usbDeviceName("/sys/class/hidraw/"+name+"/device/../..");
+        if( !usbName.empty() )
+            hidrawDevs[usbName] = "/dev/"+name;
+    }
+    // <---- Video nodes and HID devices by USB device name
+
+    // ----> Stereolabs USB devices
+    std::vector<CameraDevice> mcus;
+    for( const std::string& name : listDir("/sys/bus/usb/devices","") )
+    {
+        if( name.find(':')!=std::string::npos || name.compare(0,3,"usb")==0 )
+            continue; // interface or root hub
+
+        std::string path = "/sys/bus/usb/devices/"+name;
+
+        uint16_t vid = 0, pid = 0;
+        if( !readHexAttr(path+"/idVendor",vid) || vid!=SL_USB_VENDOR || !readHexAttr(path+"/idProduct",pid) )
+            continue;
+
+        std::string serial;
+        readAttr(path+"/serial",serial);
+
+        CameraDevice dev;
+        dev.serial_number = parseSerial(serial);
+        dev.model = modelName(pid);
+
+        if( isVideoPid(pid) )
+        {
+            dev.video_pid = pid;
+            dev.video_usb_path = name;
+            std::map<std::string,int>::iterator it = videoIds.find(name);
+            if( it!=videoIds.end() )
+            {
+                dev.video_id = it->second;
+                dev.video_dev = "/dev/video"+std::to_string(it->second);
+                if( dev.serial_number==-1 )
+                    dev.serial_number = udevSerial("video"+std::to_string(it->second));
+            }
+            mDevices.push_back(dev);
+        }
+        else if( isMcuPid(pid) )
+        {
+            dev.mcu_pid = pid;
+            dev.mcu_usb_path = name;
+            readHexAttr(path+"/bcdDevice",dev.mcu_fw_version);
+            std::map<std::string,std::string>::iterator it = hidrawDevs.find(name);
+            if( it!=hidrawDevs.end() )
+                dev.hidraw_dev = it->second;
+            mcus.push_back(dev);
+        }
+    }
+    // <---- Stereolabs USB devices
+
+    // ----> Pair each MCU with the video device of the same camera
+    // The serial number is used if available on both sides, else the hub the devices are connected to
+    for( const CameraDevice& mcu : mcus )
+    {
+        CameraDevice* cam = nullptr;
+
+        for( CameraDevice& video : mDevices )
+        {
+            if( video.mcu_pid==0 && video.model==mcu.model && mcu.serial_number!=-1 &&
+                    video.serial_number==mcu.serial_number )
+            {
+                cam = &video;
+                break;
+            }
+        }
+
+        if( !cam )
+        {
+            for( CameraDevice& video : mDevices )
+            {
+                if( video.mcu_pid==0 && video.model==mcu.model &&
+                        usbParentName(video.video_usb_path)==usbParentName(mcu.mcu_usb_path) )
+                {
+                    cam = &video;
+                    break;
+                }
+            }
+        }
+
+        if( !cam )
+        {
+            // Sensors only (e.g. video device not yet ready)
+            mDevices.push_back(mcu);
+            continue;
+        }
+
+        cam->mcu_pid = mcu.mcu_pid;
+        cam->mcu_usb_path = mcu.mcu_usb_path;
+        cam->hidraw_dev = mcu.hidraw_dev;
+        cam->mcu_fw_version = mcu.mcu_fw_version;
+        // The MCU serial number is the camera serial number
+        if( mcu.serial_number!=-1 )
+            cam->serial_number = mcu.serial_number;
+    }
+    // <---- Pair each MCU with the video device of the same camera
+
+    std::sort( mDevices.begin(), mDevices.end(), [](const CameraDevice& a, const CameraDevice& b) {
+        return a.serial_number < b.serial_number;
+    });
+}
+
+}
@@ -0,0 +1,1462 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include "imageconversion.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CVT_X86
+#include <immintrin.h>
+#define CVT_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define CVT_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CVT_NEON
+#include <arm_neon.h>
+#endif
+
+#include <string.h>           // for memcpy
+#include <math.h>             // for lrintf
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+namespace sl_oc {
+
+namespace video {
+
+// ----> BT.601 limited range coefficients, fixed point Q6
+// The luma coefficient (1.164) is applied in Q7 and halved to keep its precision
+static const int CVT_CY = 149;     // 1.164 * 128
+static const int CVT_CVR = 102;    // 1.596 * 64
+static const int CVT_CVG = -52;    // -0.813 * 64
+static const int CVT_CUG = -25;    // -0.391 * 64
+static const int CVT_CUB = 129;    // 2.018 * 64
+static const int CVT_ROUND = 32;   // 0.5 in Q6
+// <---- BT.601 limited range coefficients, fixed point Q6
+
+/*!
+ * \brief Convert the first pixels of a row, returns the number of converted pixels
+ * \param src the YUYV row
+ * \param dst the row of the packed image or of the Y plane
+ * \param dst_u the row of the U plane, only for \ref COLOR_FORMAT::YUV422P
+ * \param dst_v the row of the V plane, only for \ref COLOR_FORMAT::YUV422P
+ * \param width the number of pixels of the row
+ */
+typedef int (*RowFunc)( const uint8_t* src, uint8_t* dst, uint8_t* dst_u, uint8_t* dst_v, int width );
+
+/*!
+ * \brief Downsample two YUYV rows to a YUYV row of half width, returns the number of output pixels
+ * \param row0 the first source row
+ * \param row1 the second source row
+ * \param dst the destination row
+ * \param dst_width the number of pixels of the destination row
+ */
+typedef int (*DownFunc)( const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dst_width );
+
+// ----> Scalar kernels
+static inline uint8_t clampQ6( int val )
+{
+    // Negative values saturate to 0, values above 255 after the shift saturate to 255
+    if( val<0 )
+        return 0;
+    val >>= 6;
+    return static_cast<uint8_t>( (val>255)?255:val );
+}
+
+static inline int lumaQ6( int y )
+{
+    return (((y>16)?(y-16):0)*CVT_CY>>1) + CVT_ROUND;
+}
+
+template<int bIdx, int cn>
+static int scalarRowBgr( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    for( int x=0; x<width; x+=2, src+=4, dst+=2*cn )
+    {
+        int u = src[1]-128;
+        int v = src[3]-128;
+
+        int ruv = CVT_CVR*v;
+        int guv = CVT_CVG*v + CVT_CUG*u;
+        int buv = CVT_CUB*u;
+
+        int y0 = lumaQ6(src[0]);
+        dst[bIdx] = clampQ6(y0+buv);
+        dst[1] = clampQ6(y0+guv);
+        dst[2-bIdx] = clampQ6(y0+ruv);
+        if( cn==4 ) dst[3] = 255;
+
+        int y1 = lumaQ6(src[2]);
+        dst[cn+bIdx] = clampQ6(y1+buv);
+        dst[cn+1] = clampQ6(y1+guv);
+        dst[cn+2-bIdx] = clampQ6(y1+ruv);
+        if( cn==4 ) dst[cn+3] = 255;
+    }
+
+    return width;
+}
+
+static int scalarRowGray( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    for( int x=0; x<width; x++ )
+        dst[x] = src[2*x];
+
+    return width;
+}
+
+static int scalarRowPlanar( const uint8_t* src, uint8_t* dst, uint8_t* dst_u, uint8_t* dst_v, int width )
+{
+    for( int x=0; x<width/2; x++, src+=4 )
+    {
+        dst[2*x] = src[0];
+        dst[2*x+1] = src[2];
+        dst_u[x] = src[1];
+        dst_v[x] = src[3];
+    }
+
+    return width;
+}
+
+// Each output pixel pair averages 2x2 pixels for the luma and 4x2 pixels for the chroma:
+// rows are averaged first, then columns, with rounding up as `_mm_avg_epu8` and `vrhadd`
+static inline uint8_t avgU8( int a, int b )
+{
+    return static_cast<uint8_t>( (a+b+1)>>1 );
+}
+
+static int scalarDownRow( const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dst_width )
+{
+    for( int x=0; x<dst_width; x+=2, row0+=8, row1+=8, dst+=4 )
+    {
+        uint8_t v[8];
+        for( int i=0; i<8; i++ )
+            v[i] = avgU8(row0[i],row1[i]);
+
+        dst[0] = avgU8(v[0],v[2]);
+        dst[1] = avgU8(v[1],v[5]);
+        dst[2] = avgU8(v[4],v[6]);
+        dst[3] = avgU8(v[3],v[7]);
+    }
+
+    return dst_width;
+}
+
+static const RowFunc scalarRows[] = {
+    scalarRowBgr<0,3>, scalarRowBgr<2,3>, scalarRowBgr<0,4>, scalarRowBgr<2,4>, scalarRowGray, scalarRowPlanar
+};
+// <---- Scalar kernels
+
+#ifdef CVT_X86
+// ----> SSE4 kernels
+// Convert 8 pixels to 16 bit B, G and R values
+CVT_TARGET_SSE4 static inline void sseYuyvToBgr8( __m128i in, __m128i& b, __m128i& g, __m128i& r )
+{
+    const __m128i umask = _mm_setr_epi8(1,-128,1,-128,5,-128,5,-128,9,-128,9,-128,13,-128,13,-128);
+    const __m128i vmask = _mm_setr_epi8(3,-128,3,-128,7,-128,7,-128,11,-128,11,-128,15,-128,15,-128);
+    const __m128i c128 = _mm_set1_epi16(128);
+
+    __m128i y = _mm_and_si128( in, _mm_set1_epi16(0x00FF) );
+    y = _mm_srli_epi16( _mm_mullo_epi16( _mm_subs_epu16(y,_mm_set1_epi16(16)), _mm_set1_epi16(CVT_CY) ), 1 );
+    y = _mm_add_epi16( y, _mm_set1_epi16(CVT_ROUND) );
+
+    __m128i u = _mm_sub_epi16( _mm_shuffle_epi8(in,umask), c128 );
+    __m128i v = _mm_sub_epi16( _mm_shuffle_epi8(in,vmask), c128 );
+
+    r = _mm_srai_epi16( _mm_adds_epi16( y, _mm_mullo_epi16(v,_mm_set1_epi16(CVT_CVR)) ), 6 );
+    g = _mm_srai_epi16( _mm_adds_epi16( _mm_adds_epi16( y, _mm_mullo_epi16(v,_mm_set1_epi16(CVT_CVG)) ),
+                                        _mm_mullo_epi16(u,_mm_set1_epi16(CVT_CUG)) ), 6 );
+    b = _mm_srai_epi16( _mm_adds_epi16( y, _mm_mullo_epi16(u,_mm_set1_epi16(CVT_CUB)) ), 6 );
+}
+
+// Store 16 pixels as packed 3 channel pixels
+CVT_TARGET_SSE4 static inline void sseStore3( uint8_t* dst, __m128i c0, __m128i c1, __m128i c2 )
+{
+    const __m128i m00 = _mm_setr_epi8(0,-128,-128,1,-128,-128,2,-128,-128,3,-128,-128,4,-128,-128,5);
+    const __m128i m01 = _mm_setr_epi8(-128,0,-128,-128,1,-128,-128,2,-128,-128,3,-128,-128,4,-128,-128);
+    const __m128i m02 = _mm_setr_epi8(-128,-128,0,-128,-128,1,-128,-128,2,-128,-128,3,-128,-128,4,-128);
+    const __m128i m10 = _mm_setr_epi8(-128,-128,6,-128,-128,7,-128,-128,8,-128,-128,9,-128,-128,10,-128);
+    const __m128i m11 = _mm_setr_epi8(5,-128,-128,6,-128,-128,7,-128,-128,8,-128,-128,9,-128,-128,10);
+    const __m128i m12 = _mm_setr_epi8(-128,5,-128,-128,6,-128,-128,7,-128,-128,8,-128,-128,9,-128,-128);
+    const __m128i m20 = _mm_setr_epi8(-128,11,-128,-128,12,-128,-128,13,-128,-128,14,-128,-128,15,-128,-128);
+    const __m128i m21 = _mm_setr_epi8(-128,-128,11,-128,-128,12,-128,-128,13,-128,-128,14,-128,-128,15,-128);
+    const __m128i m22 = _mm_setr_epi8(10,-128,-128,11,-128,-128,12,-128,-128,13,-128,-128,14,-128,-128,15);
+
+    __m128i out0 = _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8(c0,m00), _mm_shuffle_epi8(c1,m01) ), _mm_shuffle_epi8(c2,m02) );
+    __m128i out1 = _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8(c0,m10), _mm_shuffle_epi8(c1,m11) ), _mm_shuffle_epi8(c2,m12) );
+    __m128i out2 = _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8(c0,m20), _mm_shuffle_epi8(c1,m21) ), _mm_shuffle_epi8(c2,m22) );
+
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(dst), out0 );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(dst+16), out1 );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(dst+32), out2 );
+}
+
+// Store 16 pixels as packed 4 channel pixels
+CVT_TARGET_SSE4 static inline void sseStore4( uint8_t* dst, __m128i c0, __m128i c1, __m128i c2 )
+{
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    __m128i lo01 = _mm_unpacklo_epi8(c0,c1);
+    __m128i hi01 = _mm_unpackhi_epi8(c0,c1);
+    __m128i lo2a = _mm_unpacklo_epi8(c2,alpha);
+    __m128i hi2a = _mm_unpackhi_epi8(c2,alpha);
+
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(lo01,lo2a) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(dst+16), _mm_unpackhi_epi16(lo01,lo2a) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(dst+32), _mm_unpacklo_epi16(hi01,hi2a) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(dst+48), _mm_unpackhi_epi16(hi01,hi2a) );
+}
+
+template<int bIdx, int cn>
+CVT_TARGET_SSE4 static int sseRowBgr( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    int x = 0;
+    for( ; x<=width-16; x+=16, src+=32, dst+=16*cn )
+    {
+        __m128i b0, g0, r0, b1, g1, r1;
+        sseYuyvToBgr8( _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), b0, g0, r0 );
+        sseYuyvToBgr8( _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+16)), b1, g1, r1 );
+
+        __m128i b = _mm_packus_epi16(b0,b1);
+        __m128i g = _mm_packus_epi16(g0,g1);
+        __m128i r = _mm_packus_epi16(r0,r1);
+
+        if( cn==3 )
+            sseStore3( dst, (bIdx==0)?b:r, g, (bIdx==0)?r:b );
+        else
+            sseStore4( dst, (bIdx==0)?b:r, g, (bIdx==0)?r:b );
+    }
+
+    return x;
+}
+
+CVT_TARGET_SSE4 static int sseRowGray( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    const __m128i ymask = _mm_set1_epi16(0x00FF);
+
+    int x = 0;
+    for( ; x<=width-16; x+=16, src+=32, dst+=16 )
+    {
+        __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+16));
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(_mm_and_si128(in0,ymask),_mm_and_si128(in1,ymask)) );
+    }
+
+    return x;
+}
+
+CVT_TARGET_SSE4 static int sseRowPlanar( const uint8_t* src, uint8_t* dst, uint8_t* dst_u, uint8_t* dst_v, int width )
+{
+    const __m128i lmask = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for( ; x<=width-16; x+=16, src+=32, dst+=16, dst_u+=8, dst_v+=8 )
+    {
+        __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+16));
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(_mm_and_si128(in0,lmask),_mm_and_si128(in1,lmask)) );
+
+        __m128i uv = _mm_packus_epi16( _mm_srli_epi16(in0,8), _mm_srli_epi16(in1,8) );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>(dst_u), _mm_packus_epi16(_mm_and_si128(uv,lmask),zero) );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>(dst_v), _mm_packus_epi16(_mm_srli_epi16(uv,8),zero) );
+    }
+
+    return x;
+}
+
+CVT_TARGET_SSE4 static int sseDownRow( const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dst_width )
+{
+    // Bytes of the two pixels pairs averaged for each output byte: [Y0,U0,Y2,V0] and [Y1,U1,Y3,V1]
+    const __m128i maskA = _mm_setr_epi8(0,1,4,3,8,9,12,11,-128,-128,-128,-128,-128,-128,-128,-128);
+    const __m128i maskB = _mm_setr_epi8(2,5,6,7,10,13,14,15,-128,-128,-128,-128,-128,-128,-128,-128);
+
+    int x = 0;
+    for( ; x<=dst_width-8; x+=8, row0+=32, row1+=32, dst+=16 )
+    {
+        __m128i v0 = _mm_avg_epu8( _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1)) );
+        __m128i v1 = _mm_avg_epu8( _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0+16)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1+16)) );
+
+        __m128i h0 = _mm_avg_epu8( _mm_shuffle_epi8(v0,maskA), _mm_shuffle_epi8(v0,maskB) );
+        __m128i h1 = _mm_avg_epu8( _mm_shuffle_epi8(v1,maskA), _mm_shuffle_epi8(v1,maskB) );
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi64(h0,h1) );
+    }
+
+    return x;
+}
+
+static const RowFunc sseRows[] = {
+    sseRowBgr<0,3>, sseRowBgr<2,3>, sseRowBgr<0,4>, sseRowBgr<2,4>, sseRowGray, sseRowPlanar
+};
+// <---- SSE4 kernels
+
+// ----> AVX2 kernels
+// Convert 16 pixels to 16 bit B, G and R values
+CVT_TARGET_AVX2 static inline void avxYuyvToBgr16( __m256i in, __m256i& b, __m256i& g, __m256i& r )
+{
+    const __m256i umask = _mm256_setr_epi8(1,-128,1,-128,5,-128,5,-128,9,-128,9,-128,13,-128,13,-128,
+                                           1,-128,1,-128,5,-128,5,-128,9,-128,9,-128,13,-128,13,-128);
+    const __m256i vmask = _mm256_setr_epi8(3,-128,3,-128,7,-128,7,-128,11,-128,11,-128,15,-128,15,-128,
+                                           3,-128,3,-128,7,-128,7,-128,11,-128,11,-128,15,-128,15,-128);
+    const __m256i c128 = _mm256_set1_epi16(128);
+
+    __m256i y = _mm256_and_si256( in, _mm256_set1_epi16(0x00FF) );
+    y = _mm256_srli_epi16( _mm256_mullo_epi16( _mm256_subs_epu16(y,_mm256_set1_epi16(16)), _mm256_set1_epi16(CVT_CY) ), 1 );
+    y = _mm256_add_epi16( y, _mm256_set1_epi16(CVT_ROUND) );
+
+    __m256i u = _mm256_sub_epi16( _mm256_shuffle_epi8(in,umask), c128 );
+    __m256i v = _mm256_sub_epi16( _mm256_shuffle_epi8(in,vmask), c128 );
+
+    r = _mm256_srai_epi16( _mm256_adds_epi16( y, _mm256_mullo_epi16(v,_mm256_set1_epi16(CVT_CVR)) ), 6 );
+    g = _mm256_srai_epi16( _mm256_adds_epi16( _mm256_adds_epi16( y, _mm256_mullo_epi16(v,_mm256_set1_epi16(CVT_CVG)) ),
+                                              _mm256_mullo_epi16(u,_mm256_set1_epi16(CVT_CUG)) ), 6 );
+    b = _mm256_srai_epi16( _mm256_adds_epi16( y, _mm256_mullo_epi16(u,_mm256_set1_epi16(CVT_CUB)) ), 6 );
+}
+
+// Pack two vectors of 16 bit values keeping the pixel order across the 128 bit lanes
+CVT_TARGET_AVX2 static inline __m256i avxPack( __m256i lo, __m256i hi )
+{
+    return _mm256_permute4x64_epi64( _mm256_packus_epi16(lo,hi), 0xD8 );
+}
+
+template<int bIdx, int cn>
+CVT_TARGET_AVX2 static int avxRowBgr( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    int x = 0;
+    for( ; x<=width-32; x+=32, src+=64, dst+=32*cn )
+    {
+        __m256i b0, g0, r0, b1, g1, r1;
+        avxYuyvToBgr16( _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), b0, g0, r0 );
+        avxYuyvToBgr16( _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+32)), b1, g1, r1 );
+
+        __m256i b = avxPack(b0,b1);
+        __m256i g = avxPack(g0,g1);
+        __m256i r = avxPack(r0,r1);
+
+        __m256i c0 = (bIdx==0)?b:r;
+        __m256i c2 = (bIdx==0)?r:b;
+
+        if( cn==3 )
+        {
+            sseStore3( dst, _mm256_castsi256_si128(c0), _mm256_castsi256_si128(g), _mm256_castsi256_si128(c2) );
+            sseStore3( dst+48, _mm256_extracti128_si256(c0,1), _mm256_extracti128_si256(g,1), _mm256_extracti128_si256(c2,1) );
+        }
+        else
+        {
+            sseStore4( dst, _mm256_castsi256_si128(c0), _mm256_castsi256_si128(g), _mm256_castsi256_si128(c2) );
+            sseStore4( dst+64, _mm256_extracti128_si256(c0,1), _mm256_extracti128_si256(g,1), _mm256_extracti128_si256(c2,1) );
+        }
+    }
+
+    return x;
+}
+
+CVT_TARGET_AVX2 static int avxRowGray( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    const __m256i ymask = _mm256_set1_epi16(0x00FF);
+
+    int x = 0;
+    for( ; x<=width-32; x+=32, src+=64, dst+=32 )
+    {
+        __m256i in0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        __m256i in1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+32));
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(dst), avxPack(_mm256_and_si256(in0,ymask),_mm256_and_si256(in1,ymask)) );
+    }
+
+    return x;
+}
+
+CVT_TARGET_AVX2 static int avxRowPlanar( const uint8_t* src, uint8_t* dst, uint8_t* dst_u, uint8_t* dst_v, int width )
+{
+    const __m256i lmask = _mm256_set1_epi16(0x00FF);
+
+    int x = 0;
+    for( ; x<=width-32; x+=32, src+=64, dst+=32, dst_u+=16, dst_v+=16 )
+    {
+        __m256i in0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        __m256i in1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+32));
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(dst), avxPack(_mm256_and_si256(in0,lmask),_mm256_and_si256(in1,lmask)) );
+
+        // U0 V0 U1 V1 ... for the 32 pixels, then U and V separated
+        __m256i uv = avxPack( _mm256_srli_epi16(in0,8), _mm256_srli_epi16(in1,8) );
+        __m256i uu = avxPack( _mm256_and_si256(uv,lmask), _mm256_setzero_si256() );
+        __m256i vv = avxPack( _mm256_srli_epi16(uv,8), _mm256_setzero_si256() );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(dst_u), _mm256_castsi256_si128(uu) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(dst_v), _mm256_castsi256_si128(vv) );
+    }
+
+    return x;
+}
+
+static const RowFunc avxRows[] = {
+    avxRowBgr<0,3>, avxRowBgr<2,3>, avxRowBgr<0,4>, avxRowBgr<2,4>, avxRowGray, avxRowPlanar
+};
+// <---- AVX2 kernels
+#endif // CVT_X86
+
+#ifdef CVT_NEON
+// ----> NEON kernels
+// Convert 8 pixels sharing their chroma two by two to 16 bit B, G and R values
+static inline void neonYuvToBgr8( uint8x8_t y8, int16x8_t buv, int16x8_t guv, int16x8_t ruv,
+                                  uint8x8_t& b, uint8x8_t& g, uint8x8_t& r )
+{
+    uint16x8_t yl = vshrq_n_u16( vmulq_n_u16( vqsubq_u16(vmovl_u8(y8),vdupq_n_u16(16)), CVT_CY ), 1 );
+    int16x8_t y = vaddq_s16( vreinterpretq_s16_u16(yl), vdupq_n_s16(CVT_ROUND) );
+
+    b = vqmovun_s16( vshrq_n_s16( vqaddq_s16(y,buv), 6 ) );
+    g = vqmovun_s16( vshrq_n_s16( vqaddq_s16(y,guv), 6 ) );
+    r = vqmovun_s16( vshrq_n_s16( vqaddq_s16(y,ruv), 6 ) );
+}
+
+// Convert 16 pixels: 8 even pixels, 8 odd pixels and their 8 chroma pairs
+static inline void neonYuyvToBgr16( uint8x8_t y_even, uint8x8_t y_odd, uint8x8_t u8, uint8x8_t v8,
+                                    uint8x16_t& b, uint8x16_t& g, uint8x16_t& r )
+{
+    int16x8_t u = vsubq_s16( vreinterpretq_s16_u16(vmovl_u8(u8)), vdupq_n_s16(128) );
+    int16x8_t v = vsubq_s16( vreinterpretq_s16_u16(vmovl_u8(v8)), vdupq_n_s16(128) );
+
+    int16x8_t ruv = vmulq_n_s16(v,CVT_CVR);
+    int16x8_t guv = vaddq_s16( vmulq_n_s16(v,CVT_CVG), vmulq_n_s16(u,CVT_CUG) );
+    int16x8_t buv = vmulq_n_s16(u,CVT_CUB);
+
+    uint8x8_t be, ge, re, bo, go, ro;
+    neonYuvToBgr8( y_even, buv, guv, ruv, be, ge, re );
+    neonYuvToBgr8( y_odd, buv, guv, ruv, bo, go, ro );
+
+    uint8x8x2_t bz = vzip_u8(be,bo);
+    uint8x8x2_t gz = vzip_u8(ge,go);
+    uint8x8x2_t rz = vzip_u8(re,ro);
+    b = vcombine_u8(bz.val[0],bz.val[1]);
+    g = vcombine_u8(gz.val[0],gz.val[1]);
+    r = vcombine_u8(rz.val[0],rz.val[1]);
+}
+
+template<int bIdx, int cn>
+static int neonRowBgr( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    int x = 0;
+    for( ; x<=width-32; x+=32, src+=64, dst+=32*cn )
+    {
+        // val[0]: even Y, val[1]: U, val[2]: odd Y, val[3]: V
+        uint8x16x4_t in = vld4q_u8(src);
+
+        uint8x16_t b[2], g[2], r[2];
+        neonYuyvToBgr16( vget_low_u8(in.val[0]), vget_low_u8(in.val[2]), vget_low_u8(in.val[1]), vget_low_u8(in.val[3]), b[0], g[0], r[0] );
+        neonYuyvToBgr16( vget_high_u8(in.val[0]), vget_high_u8(in.val[2]), vget_high_u8(in.val[1]), vget_high_u8(in.val[3]), b[1], g[1], r[1] );
+
+        for( int h=0; h<2; h++ )
+        {
+            if( cn==3 )
+            {
+                uint8x16x3_t out;
+                out.val[bIdx] = b[h];
+                out.val[1] = g[h];
+                out.val[2-bIdx] = r[h];
+                vst3q_u8( dst+h*48, out );
+            }
+            else
+            {
+                uint8x16x4_t out;
+                out.val[bIdx] = b[h];
+                out.val[1] = g[h];
+                out.val[2-bIdx] = r[h];
+                out.val[3] = vdupq_n_u8(255);
+                vst4q_u8( dst+h*64, out );
+            }
+        }
+    }
+
+    return x;
+}
+
+static int neonRowGray( const uint8_t* src, uint8_t* dst, uint8_t*, uint8_t*, int width )
+{
+    int x = 0;
+    for( ; x<=width-16; x+=16, src+=32, dst+=16 )
+    {
+        uint8x16x2_t in = vld2q_u8(src);
+        vst1q_u8( dst, in.val[0] );
+    }
+
+    return x;
+}
+
+static int neonRowPlanar( const uint8_t* src, uint8_t* dst, uint8_t* dst_u, uint8_t* dst_v, int width )
+{
+    int x = 0;
+    for( ; x<=width-32; x+=32, src+=64, dst+=32, dst_u+=16, dst_v+=16 )
+    {
+        uint8x16x4_t in = vld4q_u8(src);
+
+        uint8x16x2_t y;
+        y.val[0] = in.val[0];
+        y.val[1] = in.val[2];
+        vst2q_u8( dst, y );
+        vst1q_u8( dst_u, in.val[1] );
+        vst1q_u8( dst_v, in.val[3] );
+    }
+
+    return x;
+}
+
+static int neonDownRow( const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int dst_width )
+{
+    int x = 0;
+    for( ; x<=dst_width-16; x+=16, row0+=64, row1+=64, dst+=32 )
+    {
+        // val[0]: even Y, val[1]: U, val[2]: odd Y, val[3]: V of 16 pixel pairs
+        uint8x16x4_t in0 = vld4q_u8(row0);
+        uint8x16x4_t in1 = vld4q_u8(row1);
+
+        uint8x16_t y = vrhaddq_u8( vrhaddq_u8(in0.val[0],in1.val[0]), vrhaddq_u8(in0.val[2],in1.val[2]) );
+        uint8x16_t u = vrhaddq_u8(in0.val[1],in1.val[1]);
+        uint8x16_t v = vrhaddq_u8(in0.val[3],in1.val[3]);
+
+        uint8x8x2_t yz = vuzp_u8( vget_low_u8(y), vget_high_u8(y) );
+        uint8x8x2_t uz = vuzp_u8( vget_low_u8(u), vget_high_u8(u) );
+        uint8x8x2_t vz = vuzp_u8( vget_low_u8(v), vget_high_u8(v) );
+
+        uint8x8x4_t out;
+        out.val[0] = yz.val[0];
+        out.val[1] = vrhadd_u8(uz.val[0],uz.val[1]);
+        out.val[2] = yz.val[1];
+        out.val[3] = vrhadd_u8(vz.val[0],vz.val[1]);
+        vst4_u8( dst, out );
+    }
+
+    return x;
+}
+
+static const RowFunc neonRows[] = {
+    neonRowBgr<0,3>, neonRowBgr<2,3>, neonRowBgr<0,4>, neonRowBgr<2,4>, neonRowGray, neonRowPlanar
+};
+// <---- NEON kernels
+#endif // CVT_NEON
+
+// ----> Kernel selection
+static bool isKernelSupported( CONVERSION_KERNEL kernel )
+{
+    switch(kernel)
+    {
+    case CONVERSION_KERNEL::SCALAR:
+        return true;
+#ifdef CVT_X86
+    case CONVERSION_KERNEL::SSE4:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case CONVERSION_KERNEL::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef CVT_NEON
+    case CONVERSION_KERNEL::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+static CONVERSION_KERNEL detectKernel()
+{
+    const CONVERSION_KERNEL kernels[] = {CONVERSION_KERNEL::AVX2, CONVERSION_KERNEL::NEON, CONVERSION_KERNEL::SSE4};
+    for( CONVERSION_KERNEL kernel : kernels )
+    {
+        if( isKernelSupported(kernel) )
+            return kernel;
+    }
+
+    return CONVERSION_KERNEL::SCALAR;
+}
+
+static std::atomic<CONVERSION_KERNEL>& currentKernel()
+{
+    static std::atomic<CONVERSION_KERNEL> kernel(detectKernel());
+    return kernel;
+}
+
+static const RowFunc* getRowFuncs( CONVERSION_KERNEL kernel )
+{
+    switch(kernel)
+    {
+#ifdef CVT_X86
+    case CONVERSION_KERNEL::SSE4:
+        return sseRows;
+    case CONVERSION_KERNEL::AVX2:
+        return avxRows;
+#endif
+#ifdef CVT_NEON
+    case CONVERSION_KERNEL::NEON:
+        return neonRows;
+#endif
+    default:
+        return scalarRows;
+    }
+}
+
+static DownFunc getDownFunc( CONVERSION_KERNEL kernel )
+{
+    switch(kernel)
+    {
+#ifdef CVT_X86
+    case CONVERSION_KERNEL::SSE4:
+    case CONVERSION_KERNEL::AVX2:
+        return sseDownRow;
+#endif
+#ifdef CVT_NEON
+    case CONVERSION_KERNEL::NEON:
+        return neonDownRow;
+#endif
+    default:
+        return scalarDownRow;
+    }
+}
+
+bool setConversionKernel( CONVERSION_KERNEL kernel )
+{
+    if( kernel==CONVERSION_KERNEL::AUTO )
+        kernel = detectKernel();
+
+    if( !isKernelSupported(kernel) )
+        return false;
+
+    currentKernel() = kernel;
+    return true;
+}
+
+CONVERSION_KERNEL getConversionKernel()
+{
+    return currentKernel();
+}
+// <---- Kernel selection
+
+// ----> Row band thread pool
+/*!
+ * \brief Pool of threads converting the row bands of an image with the calling thread. A single conversion uses
+ * the pool at a time, concurrent conversions run in their calling thread.
+ */
+class RowBandPool
+{
+public:
+    static RowBandPool& instance()
+    {
+        static RowBandPool pool;
+        return pool;
+    }
+
+    int getThreadCount() const {return static_cast<int>(mWorkers.size())+1;}
+
+    void run( int bands, const std::function<void(int)>& job )
+    {
+        std::unique_lock<std::mutex> runLock(mRunMutex, std::try_to_lock);
+        if( bands<=1 || mWorkers.empty() || !runLock.owns_lock() )
+        {
+            for( int band=0; band<bands; band++ )
+                job(band);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJob = &job;
+        mBands = bands;
+        mNextBand = 0;
+        mActive = static_cast<int>(mWorkers.size());
+        mGeneration++;
+        lock.unlock();
+        mWorkCond.notify_all();
+
+        processBands( job, bands );
+
+        lock.lock();
+        mDoneCond.wait( lock, [this]{return mActive==0;} );
+        mJob = nullptr;
+    }
+
+private:
+    RowBandPool()
+    {
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        for( int i=1; i<cores; i++ )
+            mWorkers.push_back( std::thread( &RowBandPool::workerFunc, this ) );
+    }
+
+    ~RowBandPool()
+    {
+        mMutex.lock();
+        mStop = true;
+        mMutex.unlock();
+        mWorkCond.notify_all();
+
+        for( std::thread& th : mWorkers )
+            th.join();
+    }
+
+    void processBands( const std::function<void(int)>& job, int bands )
+    {
+        int band;
+        while( (band=mNextBand.fetch_add(1))<bands )
+            job(band);
+    }
+
+    void workerFunc()
+    {
+        uint64_t generation = 0;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        while(true)
+        {
+            mWorkCond.wait( lock, [this,&generation]{return mStop || mGeneration!=generation;} );
+            if( mStop )
+                return;
+
+            generation = mGeneration;
+            const std::function<void(int)>* job = mJob;
+            int bands = mBands;
+
+            lock.unlock();
+            processBands( *job, bands );
+            lock.lock();
+
+            if( --mActive==0 )
+                mDoneCond.notify_one();
+        }
+    }
+
+    std::vector<std::thread> mWorkers;      //!< The worker threads
+    std::mutex mRunMutex;                   //!< Locked while a conversion uses the pool
+    std::mutex mMutex;                      //!< Mutex for safe access to the job
+    std::condition_variable mWorkCond;      //!< Signals a new job to the workers
+    std::condition_variable mDoneCond;      //!< Signals the end of the job to the calling thread
+    const std::function<void(int)>* mJob = nullptr; //!< The current job, called with the band index
+    int mBands = 0;                         //!< Number of bands of the current job
+    std::atomic<int> mNextBand{0};          //!< Index of the next band to process
+    int mActive = 0;                        //!< Number of workers still processing the current job
+    uint64_t mGeneration = 0;               //!< Index of the current job
+    bool mStop = false;                     //!< Indicates if the workers must stop
+};
+// <---- Row band thread pool
+
+int getColorFormatChannels( COLOR_FORMAT format )
+{
+    switch(format)
+    {
+    case COLOR_FORMAT::BGR:
+    case COLOR_FORMAT::RGB:
+        return 3;
+    case COLOR_FORMAT::BGRA:
+    case COLOR_FORMAT::RGBA:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+size_t getConvertedSize( int width, int height, COLOR_FORMAT format )
+{
+    size_t pixels = static_cast<size_t>(width)*height;
+
+    if( format==COLOR_FORMAT::YUV422P )
+        return 2*pixels;
+
+    return pixels*getColorFormatChannels(format);
+}
+
+/*!
+ * \brief Convert side by side images in a single pass over the source rows
+ * \param src the first row of the YUYV image
+ * \param src_step the size in bytes of a source row
+ * \param dst the destination buffer of each view
+ * \param dst_step the size in bytes of a destination row
+ * \param views the number of side by side views, each `width` pixels wide
+ */
+static bool convertViews( const uint8_t* src, size_t src_step, uint8_t* const* dst, size_t dst_step,
+                          int views, int width, int height, COLOR_FORMAT format, int threads )
+{
+    const int cn = getColorFormatChannels(format);
+
+    if( !src || width<=0 || height<=0 || (width&1) ||
+            src_step<2*static_cast<size_t>(width)*views || dst_step<static_cast<size_t>(width)*cn )
+        return false;
+
+    for( int v=0; v<views; v++ )
+    {
+        if( !dst[v] )
+            return false;
+    }
+
+    const RowFunc rowFunc = getRowFuncs( getConversionKernel() )[static_cast<int>(format)];
+    const RowFunc tailFunc = scalarRows[static_cast<int>(format)];
+
+    const bool planar = (format==COLOR_FORMAT::YUV422P);
+    const size_t chroma_step = dst_step/2;
+
+    // ----> Row bands of at least 16 rows
+    RowBandPool& pool = RowBandPool::instance();
+    int bands = (threads<=0)?pool.getThreadCount():std::min(threads,pool.getThreadCount());
+    bands = std::max( 1, std::min( bands, height/16 ) );
+    int bandRows = (height+bands-1)/bands;
+    // <---- Row bands of at least 16 rows
+
+    auto job = [&](int band) {
+        int rowEnd = std::min( height, (band+1)*bandRows );
+        for( int row=band*bandRows; row<rowEnd; row++ )
+        {
+            for( int v=0; v<views; v++ )
+            {
+                const uint8_t* s = src + row*src_step + 2*static_cast<size_t>(width)*v;
+                uint8_t* d = dst[v] + row*dst_step;
+                uint8_t* du = planar?(dst[v] + dst_step*height + row*chroma_step):nullptr;
+                uint8_t* dv = planar?(dst[v] + (dst_step+chroma_step)*height + row*chroma_step):nullptr;
+
+                int done = rowFunc( s, d, du, dv, width );
+                if( done<width )
+                {
+                    tailFunc( s + 2*done, d + done*cn, planar?(du + done/2):nullptr, planar?(dv + done/2):nullptr, width-done );
+                }
+            }
+        }
+    };
+
+    if( bands==1 )
+        job(0); // e.g. single rows converted while the frame is copied
+    else
+        pool.run( bands, std::function<void(int)>(job) );
+
+    return true;
+}
+
+bool convertYUYV( const uint8_t* src, size_t src_step, uint8_t* dst, size_t dst_step,
+                  int width, int height, COLOR_FORMAT format, int threads )
+{
+    return convertViews( src, src_step, &dst, dst_step, 1, width, height, format, threads );
+}
+
+bool downsampleYUYV( const uint8_t* src, size_t src_step, uint8_t* dst, size_t dst_step,
+                     int width, int height, int threads )
+{
+    const int dstWidth = (width/2)&~1;
+    const int dstHeight = height/2;
+
+    if( !src || !dst || dstWidth<=0 || dstHeight<=0 ||
+            src_step<2*static_cast<size_t>(width) || dst_step<2*static_cast<size_t>(dstWidth) )
+        return false;
+
+    const DownFunc downFunc = getDownFunc( getConversionKernel() );
+
+    // ----> Row bands of at least 16 rows
+    RowBandPool& pool = RowBandPool::instance();
+    int bands = (threads<=0)?pool.getThreadCount():std::min(threads,pool.getThreadCount());
+    bands = std::max( 1, std::min( bands, dstHeight/16 ) );
+    int bandRows = (dstHeight+bands-1)/bands;
+    // <---- Row bands of at least 16 rows
+
+    auto job = [&](int band) {
+        int rowEnd = std::min( dstHeight, (band+1)*bandRows );
+        for( int row=band*bandRows; row<rowEnd; row++ )
+        {
+            const uint8_t* r0 = src + 2*row*src_step;
+            const uint8_t* r1 = r0 + src_step;
+            uint8_t* d = dst + row*dst_step;
+
+            int done = downFunc( r0, r1, d, dstWidth );
+            if( done<dstWidth )
+                scalarDownRow( r0 + 4*done, r1 + 4*done, d + 2*done, dstWidth-done );
+        }
+    };
+
+    if( bands==1 )
+        job(0);
+    else
+        pool.run( bands, std::function<void(int)>(job) );
+
+    return true;
+}
+
+bool convertFrame( const Frame& frame, uint8_t* dst, COLOR_FORMAT format, int threads )
+{
+    if( !frame.data )
+        return false;
+
+    return convertYUYV( frame.data, 2*static_cast<size_t>(frame.width), dst,
+                        static_cast<size_t>(frame.width)*getColorFormatChannels(format),
+                        frame.width, frame.height, format, threads );
+}
+
+StereoView splitStereo( const Frame& frame )
+{
+    StereoView view;
+    view.frame_id = frame.frame_id;
+    view.timestamp = frame.timestamp;
+
+    if( !frame.data || frame.width<2 )
+        return view;
+
+    ImageView eye;
+    eye.width = frame.width/2;
+    eye.height = frame.height;
+    eye.channels = frame.channels;
+    eye.step = static_cast<size_t>(frame.width)*frame.channels;
+
+    view.left = eye;
+    view.left.data = frame.data;
+
+    view.right = eye;
+    view.right.data = frame.data + static_cast<size_t>(eye.width)*frame.channels;
+
+    return view;
+}
+
+bool convertView( const ImageView& view, uint8_t* dst, COLOR_FORMAT format, int threads )
+{
+    if( view.channels!=2 )
+        return false;
+
+    return convertYUYV( view.data, view.step, dst, static_cast<size_t>(view.width)*getColorFormatChannels(format),
+                        view.width, view.height, format, threads );
+}
+
+bool convertStereo( const Frame& frame, uint8_t* left, uint8_t* right, COLOR_FORMAT format, int threads )
+{
+    if( !frame.data )
+        return false;
+
+    int width = frame.width/2;
+    uint8_t* const dst[2] = {left, right};
+
+    return convertViews( frame.data, 2*static_cast<size_t>(frame.width), dst,
+                         static_cast<size_t>(width)*getColorFormatChannels(format),
+                         2, width, frame.height, format, threads );
+}
+
+// ----> Remap
+#define REMAP_FRAC_BITS     5                           // Sub-pixel precision of the remap tables
+#define REMAP_FRAC_SIZE     (1<<REMAP_FRAC_BITS)
+#define REMAP_WEIGHT_BITS   (2*REMAP_FRAC_BITS)         // Bilinear weights sum to 1<<REMAP_WEIGHT_BITS
+#define REMAP_ROUND         (1<<(REMAP_WEIGHT_BITS-1))
+
+typedef void (*RemapFunc)( const ImageView& src, const int16_t* xy, const uint16_t* frac, const uint8_t* border,
+                           uint8_t* dst, int width );
+
+size_t RemapTable::getDataSize( int width, int height )
+{
+    size_t pixels = static_cast<size_t>(width)*height;
+    size_t size = 6*pixels + static_cast<size_t>((width+7)/8)*height;
+    return (size+7) & ~static_cast<size_t>(7);
+}
+
+void RemapTable::create( int width, int height, int src_width, int src_height )
+{
+    size_t size = getDataSize( width, height );
+
+    std::shared_ptr<uint8_t> owner( new uint8_t[size], std::default_delete<uint8_t[]>() );
+    memset( owner.get(), 0, size );
+
+    attach( width, height, src_width, src_height, owner.get(), owner );
+}
+
+void RemapTable::attach( int width, int height, int src_width, int src_height, uint8_t* data, std::shared_ptr<uint8_t> owner )
+{
+    this->width = width;
+    this->height = height;
+    this->src_width = src_width;
+    this->src_height = src_height;
+
+    size_t pixels = static_cast<size_t>(width)*height;
+    xy = reinterpret_cast<int16_t*>(data);
+    frac = reinterpret_cast<uint16_t*>(data + 4*pixels);
+    border = data + 6*pixels;
+    memory = owner;
+}
+
+void RemapTable::set( int x, int y, float src_x, float src_y )
+{
+    // ----> Round to the sub-pixel grid, saturated to the 16 bit coordinates
+    const float limit = 32767.f*REMAP_FRAC_SIZE;
+    int ix = static_cast<int>( lrintf( std::max( -limit, std::min( limit, src_x*REMAP_FRAC_SIZE ) ) ) );
+    int iy = static_cast<int>( lrintf( std::max( -limit, std::min( limit, src_y*REMAP_FRAC_SIZE ) ) ) );
+    // <---- Round to the sub-pixel grid, saturated to the 16 bit coordinates
+
+    int sx = ix>>REMAP_FRAC_BITS;
+    int sy = iy>>REMAP_FRAC_BITS;
+
+    size_t idx = static_cast<size_t>(y)*width + x;
+    xy[2*idx] = static_cast<int16_t>(sx);
+    xy[2*idx+1] = static_cast<int16_t>(sy);
+    frac[idx] = static_cast<uint16_t>( (ix&(REMAP_FRAC_SIZE-1)) | ((iy&(REMAP_FRAC_SIZE-1))<<REMAP_FRAC_BITS) );
+
+    // The SIMD kernels read up to 4 pixels of a row from the top left pixel of the neighbourhood
+    if( sx<0 || sy<0 || sx+3>=src_width || sy+1>=src_height )
+        border[static_cast<size_t>(y)*((width+7)/8) + x/8] = 1;
+}
+
+static void scalarRemapRow( const ImageView& src, const int16_t* xy, const uint16_t* frac, const uint8_t*,
+                            uint8_t* dst, int width )
+{
+    const int cn = src.channels;
+    const size_t step = src.step;
+
+    for( int x=0; x<width; x++, dst+=cn )
+    {
+        const int sx = xy[2*x];
+        const int sy = xy[2*x+1];
+        const int fx = frac[x]&(REMAP_FRAC_SIZE-1);
+        const int fy = frac[x]>>REMAP_FRAC_BITS;
+
+        const int w[4] = { (REMAP_FRAC_SIZE-fx)*(REMAP_FRAC_SIZE-fy), fx*(REMAP_FRAC_SIZE-fy),
+                           (REMAP_FRAC_SIZE-fx)*fy, fx*fy };
+
+        if( static_cast<unsigned>(sx)<static_cast<unsigned>(src.width-1) &&
+                static_cast<unsigned>(sy)<static_cast<unsigned>(src.height-1) )
+        {
+            const uint8_t* p = src.data + sy*step + sx*cn;
+            for( int c=0; c<cn; c++ )
+            {
+                dst[c] = static_cast<uint8_t>( (p[c]*w[0] + p[c+cn]*w[1] + p[step+c]*w[2] + p[step+c+cn]*w[3] +
+                                               REMAP_ROUND) >> REMAP_WEIGHT_BITS );
+            }
+            continue;
+        }
+
+        // ----> Neighbourhood crossing the border: the pixels outside the image are black
+        for( int c=0; c<cn; c++ )
+        {
+            int sum = REMAP_ROUND;
+            for( int k=0; k<4; k++ )
+            {
+                int px = sx + (k&1);
+                int py = sy + (k>>1);
+                if( px>=0 && py>=0 && px<src.width && py<src.height )
+                    sum += src.data[py*step + px*cn + c]*w[k];
+            }
+            dst[c] = static_cast<uint8_t>( sum>>REMAP_WEIGHT_BITS );
+        }
+        // <---- Neighbourhood crossing the border: the pixels outside the image are black
+    }
+}
+
+// Store a remapped YUV pixel in a packed output format, `cn==1` for the luma only
+template<int bIdx, int cn>
+static inline void storeYuvPixel( int y, int u, int v, uint8_t* dst )
+{
+    if( cn==1 )
+    {
+        dst[0] = static_cast<uint8_t>(y);
+        return;
+    }
+
+    u -= 128;
+    v -= 128;
+
+    int yq = lumaQ6(y);
+    dst[bIdx] = clampQ6(yq + CVT_CUB*u);
+    dst[1] = clampQ6(yq + CVT_CVG*v + CVT_CUG*u);
+    dst[2-bIdx] = clampQ6(yq + CVT_CVR*v);
+    if( cn==4 ) dst[3] = 255;
+}
+
+// Remap of a YUYV image: Y, U and V are interpolated separately, the chroma of a pixel being the one of its pair
+template<int bIdx, int cn>
+static void scalarRemapYuyvRow( const ImageView& src, const int16_t* xy, const uint16_t* frac, const uint8_t*,
+                                uint8_t* dst, int width )
+{
+    const size_t step = src.step;
+    const int planes = (cn==1)?1:3;
+
+    // Black: luma 0 for the gray output as for the remap of a gray image, converted to (0,0,0) for the colors
+    const int black[3] = { (cn==1)?0:16, 128, 128 };
+
+    for( int x=0; x<width; x++, dst+=cn )
+    {
+        const int sx = xy[2*x];
+        const int sy = xy[2*x+1];
+        const int fx = frac[x]&(REMAP_FRAC_SIZE-1);
+        const int fy = frac[x]>>REMAP_FRAC_BITS;
+
+        const int w[4] = { (REMAP_FRAC_SIZE-fx)*(REMAP_FRAC_SIZE-fy), fx*(REMAP_FRAC_SIZE-fy),
+                           (REMAP_FRAC_SIZE-fx)*fy, fx*fy };
+
+        int yuv[3] = { REMAP_ROUND, REMAP_ROUND, REMAP_ROUND };
+        for( int k=0; k<4; k++ )
+        {
+            int px = sx + (k&1);
+            int py = sy + (k>>1);
+
+            if( px>=0 && py>=0 && px<src.width && py<src.height )
+            {
+                const uint8_t* row = src.data + py*step;
+                yuv[0] += row[2*px]*w[k];
+                if( planes==3 )
+                {
+                    yuv[1] += row[4*(px>>1)+1]*w[k];
+                    yuv[2] += row[4*(px>>1)+3]*w[k];
+                }
+            }
+            else
+            {
+                for( int c=0; c<planes; c++ )
+                    yuv[c] += black[c]*w[k];
+            }
+        }
+
+        storeYuvPixel<bIdx,cn>( yuv[0]>>REMAP_WEIGHT_BITS, yuv[1]>>REMAP_WEIGHT_BITS, yuv[2]>>REMAP_WEIGHT_BITS, dst );
+    }
+}
+
+// Scalar remap of the luma, from a gray image (STRIDE 1) or a YUYV image (STRIDE 2)
+template<int STRIDE>
+static inline void scalarRemapLuma( const ImageView& src, const int16_t* xy, const uint16_t* frac, uint8_t* dst, int width )
+{
+    if( STRIDE==1 )
+        scalarRemapRow( src, xy, frac, nullptr, dst, width );
+    else
+        scalarRemapYuyvRow<0,1>( src, xy, frac, nullptr, dst, width );
+}
+
+static const RemapFunc scalarRemapYuyv[] = {
+    scalarRemapYuyvRow<0,3>, scalarRemapYuyvRow<2,3>, scalarRemapYuyvRow<0,4>, scalarRemapYuyvRow<2,4>,
+    scalarRemapYuyvRow<0,1>
+};
+
+#ifdef CVT_X86
+// Bilinear weights of 4 pixels as 16 bit pairs: top row in `top`, bottom row in `bottom`
+CVT_TARGET_SSE4 static inline void sseRemapWeights( const uint16_t* frac, __m128i& top, __m128i& bottom )
+{
+    const __m128i f = _mm_cvtepu16_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i*>(frac) ) );
+    const __m128i size = _mm_set1_epi32(REMAP_FRAC_SIZE);
+    const __m128i fx = _mm_and_si128( f, _mm_set1_epi32(REMAP_FRAC_SIZE-1) );
+    const __m128i fy = _mm_srli_epi32( f, REMAP_FRAC_BITS );
+    const __m128i ifx = _mm_sub_epi32( size, fx );
+    const __m128i ify = _mm_sub_epi32( size, fy );
+
+    top = _mm_or_si128( _mm_mullo_epi32(ifx,ify), _mm_slli_epi32( _mm_mullo_epi32(fx,ify), 16 ) );
+    bottom = _mm_or_si128( _mm_mullo_epi32(ifx,fy), _mm_slli_epi32( _mm_mullo_epi32(fx,fy), 16 ) );
+}
+
+// Four bytes from a pixel, including its right neighbour
+static inline int loadQuad( const uint8_t* p )
+{
+    int quad;
+    memcpy( &quad, p, sizeof(quad) );
+    return quad;
+}
+
+// Luma of a gray image (STRIDE 1) or of a YUYV image (STRIDE 2), 4 pixels at a time
+template<int STRIDE>
+CVT_TARGET_SSE4 static void sseRemapRowGray( const ImageView& src, const int16_t* xy, const uint16_t* frac,
+                                             const uint8_t* border, uint8_t* dst, int width )
+{
+    const size_t step = src.step;
+    const __m128i shuf = _mm_setr_epi8( 0,-1,STRIDE,-1, 4,-1,4+STRIDE,-1, 8,-1,8+STRIDE,-1, 12,-1,12+STRIDE,-1 );
+    const __m128i round = _mm_set1_epi32(REMAP_ROUND);
+
+    int x = 0;
+    for( ; x+8<=width; x+=8 )
+    {
+        if( border[x/8] )
+        {
+            scalarRemapLuma<STRIDE>( src, xy+2*x, frac+x, dst+x, 8 );
+            continue;
+        }
+
+        for( int i=x; i<x+8; i+=4 )
+        {
+            const uint8_t* p[4];
+            for( int k=0; k<4; k++ )
+                p[k] = src.data + xy[2*(i+k)+1]*step + xy[2*(i+k)]*STRIDE;
+
+            __m128i top = _mm_setr_epi32( loadQuad(p[0]), loadQuad(p[1]), loadQuad(p[2]), loadQuad(p[3]) );
+            __m128i bottom = _mm_setr_epi32( loadQuad(p[0]+step), loadQuad(p[1]+step),
+                                             loadQuad(p[2]+step), loadQuad(p[3]+step) );
+            __m128i wTop, wBottom;
+            sseRemapWeights( frac+i, wTop, wBottom );
+
+            __m128i sum = _mm_add_epi32( _mm_madd_epi16( _mm_shuffle_epi8(top,shuf), wTop ),
+                                         _mm_madd_epi16( _mm_shuffle_epi8(bottom,shuf), wBottom ) );
+            sum = _mm_srli_epi32( _mm_add_epi32( sum, round ), REMAP_WEIGHT_BITS );
+            sum = _mm_packus_epi32( sum, sum );
+            sum = _mm_packus_epi16( sum, sum );
+
+            int val = _mm_cvtsi128_si32(sum);
+            memcpy( dst+i, &val, 4 );
+        }
+    }
+
+    scalarRemapLuma<STRIDE>( src, xy+2*x, frac+x, dst+x, width-x );
+}
+
+// One pixel with CN channels at a time: the top and bottom neighbours are interleaved as 16 bit pairs
+template<int CN>
+CVT_TARGET_SSE4 static void sseRemapRowColor( const ImageView& src, const int16_t* xy, const uint16_t* frac,
+                                              const uint8_t* border, uint8_t* dst, int width )
+{
+    const size_t step = src.step;
+    const __m128i shufTop = _mm_setr_epi8( 0,-1,CN,-1, 1,-1,CN+1,-1, 2,-1,CN+2,-1, 3,-1,CN+3,-1 );
+    const __m128i shufBottom = _mm_add_epi8( shufTop, _mm_setr_epi8( 8,0,8,0, 8,0,8,0, 8,0,8,0, 8,0,8,0 ) );
+    const __m128i round = _mm_set1_epi32(REMAP_ROUND);
+
+    int x = 0;
+    for( ; x+8<=width; x+=8 )
+    {
+        if( border[x/8] )
+        {
+            scalarRemapRow( src, xy+2*x, frac+x, nullptr, dst+x*CN, 8 );
+            continue;
+        }
+
+        for( int i=x; i<x+8; i++ )
+        {
+            const uint8_t* p = src.data + xy[2*i+1]*step + xy[2*i]*CN;
+            const int fx = frac[i]&(REMAP_FRAC_SIZE-1);
+            const int fy = frac[i]>>REMAP_FRAC_BITS;
+
+            const __m128i wTop = _mm_set1_epi32( ((REMAP_FRAC_SIZE-fx)*(REMAP_FRAC_SIZE-fy)) | ((fx*(REMAP_FRAC_SIZE-fy))<<16) );
+            const __m128i wBottom = _mm_set1_epi32( ((REMAP_FRAC_SIZE-fx)*fy) | ((fx*fy)<<16) );
+
+            __m128i px = _mm_unpacklo_epi64( _mm_loadl_epi64( reinterpret_cast<const __m128i*>(p) ),
+                                             _mm_loadl_epi64( reinterpret_cast<const __m128i*>(p+step) ) );
+
+            __m128i sum = _mm_add_epi32( _mm_madd_epi16( _mm_shuffle_epi8(px,shufTop), wTop ),
+                                         _mm_madd_epi16( _mm_shuffle_epi8(px,shufBottom), wBottom ) );
+            sum = _mm_srli_epi32( _mm_add_epi32( sum, round ), REMAP_WEIGHT_BITS );
+            sum = _mm_packus_epi32( sum, sum );
+            sum = _mm_packus_epi16( sum, sum );
+
+            int val = _mm_cvtsi128_si32(sum);
+            memcpy( dst+i*CN, &val, CN );
+        }
+    }
+
+    scalarRemapRow( src, xy+2*x, frac+x, nullptr, dst+x*CN, width-x );
+}
+
+// Luma pixels 8 at a time, gathering the two neighbours of each row with a single 32 bit load
+template<int STRIDE>
+CVT_TARGET_AVX2 static void avxRemapRowGray( const ImageView& src, const int16_t* xy, const uint16_t* frac,
+                                             const uint8_t* border, uint8_t* dst, int width )
+{
+    const __m256i step = _mm256_set1_epi32( static_cast<int>(src.step) );
+    const __m256i shuf = _mm256_setr_epi8( 0,-1,STRIDE,-1, 4,-1,4+STRIDE,-1, 8,-1,8+STRIDE,-1, 12,-1,12+STRIDE,-1,
+                                           0,-1,STRIDE,-1, 4,-1,4+STRIDE,-1, 8,-1,8+STRIDE,-1, 12,-1,12+STRIDE,-1 );
+    const __m256i size = _mm256_set1_epi32(REMAP_FRAC_SIZE);
+    const __m256i round = _mm256_set1_epi32(REMAP_ROUND);
+    const __m256i lanes = _mm256_setr_epi32( 0,4,1,5,2,6,3,7 );
+    const int* base = reinterpret_cast<const int*>(src.data);
+    const int* baseBottom = reinterpret_cast<const int*>(src.data + src.step);
+
+    int x = 0;
+    for( ; x+8<=width; x+=8 )
+    {
+        if( border[x/8] )
+        {
+            scalarRemapLuma<STRIDE>( src, xy+2*x, frac+x, dst+x, 8 );
+            continue;
+        }
+
+        // ----> Source offsets
+        __m256i coords = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(xy+2*x) );
+        __m256i sx = _mm256_srai_epi32( _mm256_slli_epi32( coords, 16 ), 17-STRIDE ); // x*STRIDE
+        __m256i sy = _mm256_srai_epi32( coords, 16 );
+        __m256i offset = _mm256_add_epi32( _mm256_mullo_epi32( sy, step ), sx );
+        // <---- Source offsets
+
+        __m256i top = _mm256_i32gather_epi32( base, offset, 1 );
+        __m256i bottom = _mm256_i32gather_epi32( baseBottom, offset, 1 );
+
+        // ----> Bilinear weights
+        __m256i f = _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(frac+x) ) );
+        __m256i fx = _mm256_and_si256( f, _mm256_set1_epi32(REMAP_FRAC_SIZE-1) );
+        __m256i fy = _mm256_srli_epi32( f, REMAP_FRAC_BITS );
+        __m256i ifx = _mm256_sub_epi32( size, fx );
+        __m256i ify = _mm256_sub_epi32( size, fy );
+        __m256i wTop = _mm256_or_si256( _mm256_mullo_epi32(ifx,ify), _mm256_slli_epi32( _mm256_mullo_epi32(fx,ify), 16 ) );
+        __m256i wBottom = _mm256_or_si256( _mm256_mullo_epi32(ifx,fy), _mm256_slli_epi32( _mm256_mullo_epi32(fx,fy), 16 ) );
+        // <---- Bilinear weights
+
+        __m256i sum = _mm256_add_epi32( _mm256_madd_epi16( _mm256_shuffle_epi8(top,shuf), wTop ),
+                                        _mm256_madd_epi16( _mm256_shuffle_epi8(bottom,shuf), wBottom ) );
+        sum = _mm256_srli_epi32( _mm256_add_epi32( sum, round ), REMAP_WEIGHT_BITS );
+        sum = _mm256_packus_epi32( sum, sum );
+        sum = _mm256_packus_epi16( sum, sum );
+        sum = _mm256_permutevar8x32_epi32( sum, lanes );
+
+        _mm_storel_epi64( reinterpret_cast<__m128i*>(dst+x), _mm256_castsi256_si128(sum) );
+    }
+
+    scalarRemapLuma<STRIDE>( src, xy+2*x, frac+x, dst+x, width-x );
+}
+
+// YUYV to colors, one pixel at a time: Y, U and V of the two neighbours of each row as 16 bit pairs
+template<int bIdx, int cn>
+CVT_TARGET_SSE4 static void sseRemapYuyvRowColor( const ImageView& src, const int16_t* xy, const uint16_t* frac,
+                                                  const uint8_t* border, uint8_t* dst, int width )
+{
+    const size_t step = src.step;
+
+    // Shuffles of the two pixel pairs starting at the pair of the left neighbour, top row then bottom row
+    const __m128i shufEven[2] = { _mm_setr_epi8( 0,-1,2,-1, 1,-1,1,-1, 3,-1,3,-1, -1,-1,-1,-1 ),
+                                  _mm_setr_epi8( 8,-1,10,-1, 9,-1,9,-1, 11,-1,11,-1, -1,-1,-1,-1 ) };
+    const __m128i shufOdd[2] = { _mm_setr_epi8( 2,-1,4,-1, 1,-1,5,-1, 3,-1,7,-1, -1,-1,-1,-1 ),
+                                 _mm_setr_epi8( 10,-1,12,-1, 9,-1,13,-1, 11,-1,15,-1, -1,-1,-1,-1 ) };
+    const __m128i round = _mm_set1_epi32(REMAP_ROUND);
+
+    int x = 0;
+    for( ; x+8<=width; x+=8 )
+    {
+        if( border[x/8] )
+        {
+            scalarRemapYuyvRow<bIdx,cn>( src, xy+2*x, frac+x, nullptr, dst+x*cn, 8 );
+            continue;
+        }
+
+        for( int i=x; i<x+8; i++ )
+        {
+            const int sx = xy[2*i];
+            const uint8_t* p = src.data + xy[2*i+1]*step + 4*(sx>>1);
+            const __m128i* shuf = (sx&1)?shufOdd:shufEven;
+            const int fx = frac[i]&(REMAP_FRAC_SIZE-1);
+            const int fy = frac[i]>>REMAP_FRAC_BITS;
+
+            const __m128i wTop = _mm_set1_epi32( ((REMAP_FRAC_SIZE-fx)*(REMAP_FRAC_SIZE-fy)) | ((fx*(REMAP_FRAC_SIZE-fy))<<16) );
+            const __m128i wBottom = _mm_set1_epi32( ((REMAP_FRAC_SIZE-fx)*fy) | ((fx*fy)<<16) );
+
+            __m128i px = _mm_unpacklo_epi64( _mm_loadl_epi64( reinterpret_cast<const __m128i*>(p) ),
+                                             _mm_loadl_epi64( reinterpret_cast<const __m128i*>(p+step) ) );
+
+            __m128i sum = _mm_add_epi32( _mm_madd_epi16( _mm_shuffle_epi8(px,shuf[0]), wTop ),
+                                         _mm_madd_epi16( _mm_shuffle_epi8(px,shuf[1]), wBottom ) );
+            sum = _mm_srli_epi32( _mm_add_epi32( sum, round ), REMAP_WEIGHT_BITS );
+
+            storeYuvPixel<bIdx,cn>( _mm_cvtsi128_si32(sum), _mm_extract_epi32(sum,1), _mm_extract_epi32(sum,2), dst+i*cn );
+        }
+    }
+
+    scalarRemapYuyvRow<bIdx,cn>( src, xy+2*x, frac+x, nullptr, dst+x*cn, width-x );
+}
+
+static const RemapFunc sseRemapYuyv[] = {
+    sseRemapYuyvRowColor<0,3>, sseRemapYuyvRowColor<2,3>, sseRemapYuyvRowColor<0,4>, sseRemapYuyvRowColor<2,4>,
+    sseRemapRowGray<2>
+};
+
+static const RemapFunc avxRemapYuyv[] = {
+    sseRemapYuyvRowColor<0,3>, sseRemapYuyvRowColor<2,3>, sseRemapYuyvRowColor<0,4>, sseRemapYuyvRowColor<2,4>,
+    avxRemapRowGray<2>
+};
+#endif // CVT_X86
+
+static RemapFunc getRemapFunc( CONVERSION_KERNEL kernel, int channels )
+{
+    switch(kernel)
+    {
+#ifdef CVT_X86
+    case CONVERSION_KERNEL::SSE4:
+    case CONVERSION_KERNEL::AVX2:
+        if( channels==1 )
+            return (kernel==CONVERSION_KERNEL::AVX2)?avxRemapRowGray<1>:sseRemapRowGray<1>;
+        return (channels==3)?sseRemapRowColor<3>:sseRemapRowColor<4>;
+#endif
+    default:
+        return scalarRemapRow;
+    }
+}
+
+static const RemapFunc* getRemapYuyvFuncs( CONVERSION_KERNEL kernel )
+{
+    switch(kernel)
+    {
+#ifdef CVT_X86
+    case CONVERSION_KERNEL::SSE4:
+        return sseRemapYuyv;
+    case CONVERSION_KERNEL::AVX2:
+        return avxRemapYuyv;
+#endif
+    default:
+        return scalarRemapYuyv;
+    }
+}
+
+/*!
+ * \brief Remap the rows of an image on row bands in parallel
+ * \param remapFunc the row kernel
+ */
+static void remapRows( const ImageView& src, const RemapTable& table, uint8_t* dst, size_t dst_step,
+                       RemapFunc remapFunc, int threads )
+{
+    const int width = table.width;
+    const int height = table.height;
+    const size_t blocks = (width+7)/8;
+
+    // ----> Row bands of at least 16 rows
+    RowBandPool& pool = RowBandPool::instance();
+    int bands = (threads<=0)?pool.getThreadCount():std::min(threads,pool.getThreadCount());
+    bands = std::max( 1, std::min( bands, height/16 ) );
+    int bandRows = (height+bands-1)/bands;
+    // <---- Row bands of at least 16 rows
+
+    auto job = [&](int band) {
+        int rowEnd = std::min( height, (band+1)*bandRows );
+        for( int row=band*bandRows; row<rowEnd; row++ )
+        {
+            size_t idx = static_cast<size_t>(row)*width;
+            remapFunc( src, &table.xy[2*idx], &table.frac[idx], &table.border[row*blocks], dst + row*dst_step, width );
+        }
+    };
+
+    if( bands==1 )
+        job(0);
+    else
+        pool.run( bands, std::function<void(int)>(job) );
+}
+
+bool remapImage( const ImageView& src, const RemapTable& table, uint8_t* dst, size_t dst_step, int threads )
+{
+    const int cn = src.channels;
+
+    if( !src.data || !dst || !table.isValid() || src.width!=table.src_width || src.height!=table.src_height ||
+            (cn!=1 && cn!=3 && cn!=4) || dst_step<static_cast<size_t>(table.width)*cn )
+        return false;
+
+    remapRows( src, table, dst, dst_step, getRemapFunc( getConversionKernel(), cn ), threads );
+    return true;
+}
+
+bool remapYUYV( const ImageView& src, const RemapTable& table, uint8_t* dst, size_t dst_step,
+                COLOR_FORMAT format, int threads )
+{
+    const int cn = getColorFormatChannels(format);
+
+    if( !src.data || !dst || !table.isValid() || src.width!=table.src_width || src.height!=table.src_height ||
+            src.channels!=2 || (src.width&1) || format==COLOR_FORMAT::YUV422P ||
+            dst_step<static_cast<size_t>(table.width)*cn )
+        return false;
+
+    remapRows( src, table, dst, dst_step, getRemapYuyvFuncs( getConversionKernel() )[static_cast<int>(format)], threads );
+    return true;
+}
+// <---- Remap
+
+}
+
+}
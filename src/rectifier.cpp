@@ -0,0 +1,916 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+
+#include "rectifier.hpp"
+
+#include <math.h>             // for sqrt, cos, sin, acos
+#include <stdlib.h>           // for getenv
+#include <stdio.h>            // for rename
+#include <string.h>           // for memcpy, memcmp
+#include <unistd.h>           // for close, getpid
+#include <fcntl.h>            // for open
+#include <sys/mman.h>         // for mmap
+#include <sys/stat.h>         // for fstat, mkdir
+#include <errno.h>
+#include <ctype.h>            // for tolower
+#include <locale.h>           // for newlocale
+
+#include <cmath>              // for std::isfinite
+
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <algorithm>
+
+namespace sl_oc {
+
+namespace video {
+
+// ----> 3x3 matrices, row major
+static void matMul( const double* a, const double* b, double* c )
+{
+    for( int r=0; r<3; r++ )
+        for( int col=0; col<3; col++ )
+            c[3*r+col] = a[3*r]*b[col] + a[3*r+1]*b[3+col] + a[3*r+2]*b[6+col];
+}
+
+static void matMulTransposed( const double* a, const double* b, double* c ) // a * b^T
+{
+    for( int r=0; r<3; r++ )
+        for( int col=0; col<3; col++ )
+            c[3*r+col] = a[3*r]*b[3*col] + a[3*r+1]*b[3*col+1] + a[3*r+2]*b[3*col+2];
+}
+
+static void matVec( const double* a, const double* v, double* res )
+{
+    for( int r=0; r<3; r++ )
+        res[r] = a[3*r]*v[0] + a[3*r+1]*v[1] + a[3*r+2]*v[2];
+}
+
+static bool matInvert( const double* a, double* inv )
+{
+    double det = a[0]*(a[4]*a[8]-a[5]*a[7]) - a[1]*(a[3]*a[8]-a[5]*a[6]) + a[2]*(a[3]*a[7]-a[4]*a[6]);
+    if( !(fabs(det)>=std::numeric_limits<double>::epsilon()) ) // NaN included
+        return false;
+
+    double id = 1.0/det;
+    inv[0] = (a[4]*a[8]-a[5]*a[7])*id;
+    inv[1] = (a[2]*a[7]-a[1]*a[8])*id;
+    inv[2] = (a[1]*a[5]-a[2]*a[4])*id;
+    inv[3] = (a[5]*a[6]-a[3]*a[8])*id;
+    inv[4] = (a[0]*a[8]-a[2]*a[6])*id;
+    inv[5] = (a[2]*a[3]-a[0]*a[5])*id;
+    inv[6] = (a[3]*a[7]-a[4]*a[6])*id;
+    inv[7] = (a[1]*a[6]-a[0]*a[7])*id;
+    inv[8] = (a[0]*a[4]-a[1]*a[3])*id;
+    return true;
+}
+
+// Rotation matrix of a Rodrigues vector, as `cv::Rodrigues`
+static void rodrigues( const double* r, double* R )
+{
+    double theta = sqrt( r[0]*r[0] + r[1]*r[1] + r[2]*r[2] );
+
+    if( theta<std::numeric_limits<double>::epsilon() )
+    {
+        const double I[9] = {1,0,0, 0,1,0, 0,0,1};
+        std::copy( I, I+9, R );
+        return;
+    }
+
+    double c = cos(theta);
+    double s = sin(theta);
+    double c1 = 1.0-c;
+    double kx = r[0]/theta, ky = r[1]/theta, kz = r[2]/theta;
+
+    R[0] = c + c1*kx*kx;    R[1] = c1*kx*ky - s*kz; R[2] = c1*kx*kz + s*ky;
+    R[3] = c1*kx*ky + s*kz; R[4] = c + c1*ky*ky;    R[5] = c1*ky*kz - s*kx;
+    R[6] = c1*kx*kz - s*ky; R[7] = c1*ky*kz + s*kx; R[8] = c + c1*kz*kz;
+}
+// <---- 3x3 matrices, row major
+
+// ----> Lens model
+/*!
+ * \brief Undistort a pixel to normalized coordinates, iteratively as `cv::undistortPoints` (5 iterations)
+ */
+static void undistortPoint( const CameraParameters& cam, double u, double v, double& x, double& y )
+{
+    const double x0 = (u-cam.cx)/cam.fx;
+    const double y0 = (v-cam.cy)/cam.fy;
+    x = x0;
+    y = y0;
+
+    for( int i=0; i<5; i++ )
+    {
+        double r2 = x*x + y*y;
+        double icdist = 1.0/(1.0 + ((cam.k3*r2 + cam.k2)*r2 + cam.k1)*r2);
+        if( icdist<0 )
+        {
+            x = x0;
+            y = y0;
+            break;
+        }
+
+        double deltaX = 2*cam.p1*x*y + cam.p2*(r2 + 2*x*x);
+        double deltaY = cam.p1*(r2 + 2*y*y) + 2*cam.p2*x*y;
+        x = (x0-deltaX)*icdist;
+        y = (y0-deltaY)*icdist;
+    }
+}
+
+/*!
+ * \brief Inscribed and bounding rectangles of the undistorted and rectified image, as `icvGetRectangles`
+ * \param inner `{x0,y0,x1,y1}` of the largest rectangle containing only valid pixels
+ * \param outer `{x0,y0,x1,y1}` of the smallest rectangle containing all the pixels
+ */
+static void getRectangles( const CameraParameters& cam, const RectifiedCamera& rect, int width, int height,
+                           double* inner, double* outer )
+{
+    const int N = 9;
+    const double* P = rect.P;
+
+    inner[0] = inner[1] = -std::numeric_limits<double>::max();
+    inner[2] = inner[3] = std::numeric_limits<double>::max();
+    outer[0] = outer[1] = std::numeric_limits<double>::max();
+    outer[2] = outer[3] = -std::numeric_limits<double>::max();
+
+    for( int gy=0; gy<N; gy++ )
+    {
+        for( int gx=0; gx<N; gx++ )
+        {
+            double x, y;
+            undistortPoint( cam, static_cast<double>(gx)*width/(N-1), static_cast<double>(gy)*height/(N-1), x, y );
+
+            const double pt[3] = {x, y, 1.0};
+            double r[3];
+            matVec( rect.R, pt, r );
+            double px = P[0]*r[0]/r[2] + P[2];
+            double py = P[5]*r[1]/r[2] + P[6];
+
+            outer[0] = std::min( outer[0], px );
+            outer[1] = std::min( outer[1], py );
+            outer[2] = std::max( outer[2], px );
+            outer[3] = std::max( outer[3], py );
+
+            if( gx==0 )
+                inner[0] = std::max( inner[0], px );
+            if( gx==N-1 )
+                inner[2] = std::min( inner[2], px );
+            if( gy==0 )
+                inner[1] = std::max( inner[1], py );
+            if( gy==N-1 )
+                inner[3] = std::min( inner[3], py );
+        }
+    }
+}
+// <---- Lens model
+
+// ----> Calibration file
+static const char* resolutionKey( RESOLUTION res )
+{
+    switch(res)
+    {
+    case RESOLUTION::HD2K:
+        return "2k";
+    case RESOLUTION::HD1080:
+        return "fhd";
+    case RESOLUTION::VGA:
+        return "vga";
+    default:
+        return "hd";
+    }
+}
+
+// Case insensitive comparison of the characters in [begin,end) with a key
+static bool keyEquals( const char* begin, const char* end, const char* key )
+{
+    for( ; begin<end; begin++, key++ )
+    {
+        if( *key=='\0' || tolower(static_cast<unsigned char>(*begin))!=*key )
+            return false;
+    }
+    return *key=='\0';
+}
+
+static int resolutionIndex( const char* begin, const char* end )
+{
+    for( int r=0; r<static_cast<int>(RESOLUTION::LAST); r++ )
+    {
+        if( keyEquals( begin, end, resolutionKey(static_cast<RESOLUTION>(r)) ) )
+            return r;
+    }
+    return -1;
+}
+
+// The first 4 keys are required
+static const struct {const char* name; double CameraParameters::* field;} cameraKeys[] = {
+    {"fx", &CameraParameters::fx}, {"fy", &CameraParameters::fy}, {"cx", &CameraParameters::cx}, {"cy", &CameraParameters::cy},
+    {"k1", &CameraParameters::k1}, {"k2", &CameraParameters::k2}, {"p1", &CameraParameters::p1}, {"p2", &CameraParameters::p2},
+    {"k3", &CameraParameters::k3}};
+
+// Stereo keys with a resolution suffix, e.g. `ty_2k`
+static const struct {const char* name; double StereoParameters::* field;} stereoKeys[] = {
+    {"ty", &StereoParameters::ty}, {"tz", &StereoParameters::tz}, {"rx", &StereoParameters::rx},
+    {"cv", &StereoParameters::ry}, {"rz", &StereoParameters::rz}};
+
+#define CAMERA_REQUIRED_MASK 0x0F
+
+static bool isBlank( char c )
+{
+    return c==' ' || c=='\t' || c=='\r';
+}
+
+bool loadStereoCalibration( const std::string& calibration_file, StereoCalibration& calib )
+{
+    calib = StereoCalibration();
+
+    // ----> Read the whole file in a single buffer
+    std::ifstream file( calibration_file.c_str(), std::ios::binary );
+    if( !file.good() )
+        return false;
+
+    std::string data( (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>() );
+    // <---- Read the whole file in a single buffer
+
+    // The values always use the '.' decimal separator, whatever the locale
+    static locale_t cLocale = newlocale( LC_ALL_MASK, "C", static_cast<locale_t>(0) );
+
+    const int resCount = static_cast<int>(RESOLUTION::LAST);
+    int cameraMask[2][resCount] = {};   // Keys found for the left and right cameras
+    bool malformed[resCount] = {};      // A value of the resolution cannot be parsed
+    bool baseline = false;
+    bool baselineMalformed = false;
+
+    // Current section: `camera` 0 for the left camera, 1 for the right one, 2 for the stereo section, -1 otherwise
+    int camera = -1;
+    int res = -1;
+
+    const char* ptr = data.c_str();
+    const char* end = ptr + data.size();
+    if( data.compare( 0, 3, "\xEF\xBB\xBF" )==0 ) // UTF-8 BOM
+        ptr += 3;
+
+    while( ptr<end )
+    {
+        // ----> Next line without comments and blanks
+        const char* lineEnd = static_cast<const char*>(memchr( ptr, '\n', end-ptr ));
+        if( !lineEnd )
+            lineEnd = end;
+
+        const char* begin = ptr;
+        const char* last = begin;
+        while( last<lineEnd && *last!=';' && *last!='#' )
+            last++;
+        ptr = lineEnd+1;
+
+        while( begin<last && isBlank(*begin) ) begin++;
+        while( last>begin && isBlank(*(last-1)) ) last--;
+        if( begin==last )
+            continue;
+        // <---- Next line without comments and blanks
+
+        if( *begin=='[' )
+        {
+            const char* close = static_cast<const char*>(memchr( begin, ']', last-begin ));
+            const char* name = begin+1;
+            const char* nameEnd = close?close:last;
+
+            camera = -1;
+            res = -1;
+            if( keyEquals( name, nameEnd, "stereo" ) )
+                camera = 2;
+            else if( nameEnd-name>9 && keyEquals( name, name+9, "left_cam_" ) )
+            {
+                res = resolutionIndex( name+9, nameEnd );
+                camera = (res<0)?-1:0;
+            }
+            else if( nameEnd-name>10 && keyEquals( name, name+10, "right_cam_" ) )
+            {
+                res = resolutionIndex( name+10, nameEnd );
+                camera = (res<0)?-1:1;
+            }
+            continue;
+        }
+
+        if( camera<0 )
+            continue;
+
+        const char* eq = static_cast<const char*>(memchr( begin, '=', last-begin ));
+        if( !eq )
+            continue;
+
+        const char* nameEnd = eq;
+        while( nameEnd>begin && isBlank(*(nameEnd-1)) ) nameEnd--;
+
+        const char* valueBegin = eq+1;
+        while( valueBegin<last && isBlank(*valueBegin) ) valueBegin++;
+
+        // The value must be a single number, e.g. a ',' decimal separator is an error
+        char* valueEnd = nullptr;
+        double value = (valueBegin<last)?strtod_l( valueBegin, &valueEnd, cLocale ):0.0;
+        bool valid = valueBegin<last && valueEnd==last && std::isfinite(value);
+
+        if( camera<2 )
+        {
+            for( size_t k=0; k<sizeof(cameraKeys)/sizeof(cameraKeys[0]); k++ )
+            {
+                if( keyEquals( begin, nameEnd, cameraKeys[k].name ) )
+                {
+                    CameraParameters& cam = (camera==0)?calib.params[res].left:calib.params[res].right;
+                    cam.*cameraKeys[k].field = value;
+                    cameraMask[camera][res] |= (1<<k);
+                    malformed[res] |= !valid;
+                    break;
+                }
+            }
+        }
+        else if( keyEquals( begin, nameEnd, "baseline" ) )
+        {
+            for( int r=0; r<resCount; r++ )
+                calib.params[r].baseline = value;
+            baseline = true;
+            baselineMalformed = !valid;
+        }
+        else
+        {
+            const char* sep = begin;
+            while( sep<nameEnd && *sep!='_' ) sep++;
+
+            int keyRes = resolutionIndex( sep+1, nameEnd );
+            if( sep==nameEnd || keyRes<0 )
+                continue;
+
+            for( size_t k=0; k<sizeof(stereoKeys)/sizeof(stereoKeys[0]); k++ )
+            {
+                if( keyEquals( begin, sep, stereoKeys[k].name ) )
+                {
+                    calib.params[keyRes].*stereoKeys[k].field = value;
+                    malformed[keyRes] |= !valid;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool available = false;
+    for( int r=0; r<resCount; r++ )
+    {
+        calib.valid[r] = baseline && !baselineMalformed && !malformed[r] &&
+                (cameraMask[0][r]&CAMERA_REQUIRED_MASK)==CAMERA_REQUIRED_MASK &&
+                (cameraMask[1][r]&CAMERA_REQUIRED_MASK)==CAMERA_REQUIRED_MASK &&
+                validateStereoParameters( calib.params[r], static_cast<RESOLUTION>(r) );
+        available |= calib.valid[r];
+    }
+
+    return available;
+}
+
+static bool validateCamera( const CameraParameters& cam, double width, double height )
+{
+    const double values[] = {cam.fx, cam.fy, cam.cx, cam.cy, cam.k1, cam.k2, cam.p1, cam.p2, cam.k3};
+    for( double value : values )
+    {
+        if( !std::isfinite(value) )
+            return false;
+    }
+
+    return cam.fx>0 && cam.fy>0 && cam.cx>0 && cam.cx<width && cam.cy>0 && cam.cy<height;
+}
+
+bool validateStereoParameters( const StereoParameters& params, RESOLUTION res )
+{
+    if( res>=RESOLUTION::LAST )
+        return false;
+
+    double width = cameraResolution[static_cast<int>(res)].width;
+    double height = cameraResolution[static_cast<int>(res)].height;
+
+    const double values[] = {params.baseline, params.ty, params.tz, params.rx, params.ry, params.rz};
+    for( double value : values )
+    {
+        if( !std::isfinite(value) )
+            return false;
+    }
+
+    return params.baseline!=0 && validateCamera( params.left, width, height ) && validateCamera( params.right, width, height );
+}
+
+bool loadStereoParameters( const std::string& calibration_file, RESOLUTION res, StereoParameters& params )
+{
+    StereoCalibration calib;
+    loadStereoCalibration( calibration_file, calib );
+    if( !calib.isValid(res) )
+        return false;
+
+    params = calib.get(res);
+    return true;
+}
+// <---- Calibration file
+
+// ----> Cache
+#define CACHE_VERSION   2
+#define CACHE_ALIGN     64
+
+#define FNV_OFFSET      0xcbf29ce484222325ULL
+#define FNV_PRIME       0x100000001b3ULL
+
+static const char cacheMagic[8] = {'Z','E','D','O','C','R','C','T'};
+
+/*!
+ * \brief Header of a cache file, followed by the left and right \ref RemapTable data, each aligned to \ref CACHE_ALIGN
+ */
+struct CacheHeader
+{
+    char magic[8];              //!< \ref cacheMagic
+    uint32_t version;           //!< \ref CACHE_VERSION
+    uint32_t header_size;       //!< Size of the header, changes with the ABI
+    int32_t serial_number;      //!< Camera serial number
+    int32_t resolution;         //!< \ref RESOLUTION of the tables
+    int32_t width;              //!< Width of the tables
+    int32_t height;             //!< Height of the tables
+    uint64_t calib_hash;        //!< Hash of the calibration file
+    uint64_t table_size;        //!< Size of each table data, see \ref RemapTable::getDataSize
+    uint64_t table_hash;        //!< Hash of the data of both tables, see \ref hashTables
+    StereoParameters params;    //!< Calibration of the resolution
+    RectifiedCamera left;       //!< Rectified left camera
+    RectifiedCamera right;      //!< Rectified right camera
+};
+
+static size_t alignCache( size_t size )
+{
+    return (size+CACHE_ALIGN-1) & ~static_cast<size_t>(CACHE_ALIGN-1);
+}
+
+// 64 bit FNV-1a hash of the content of a file
+static bool hashFile( const std::string& path, uint64_t& hash )
+{
+    std::ifstream file( path.c_str(), std::ios::binary );
+    if( !file.good() )
+        return false;
+
+    hash = FNV_OFFSET;
+    char buffer[4096];
+    while( file )
+    {
+        file.read( buffer, sizeof(buffer) );
+        std::streamsize count = file.gcount();
+        for( std::streamsize i=0; i<count; i++ )
+        {
+            hash ^= static_cast<uint8_t>(buffer[i]);
+            hash *= FNV_PRIME;
+        }
+    }
+
+    return true;
+}
+
+// FNV-1a hash of the left and right table data by 8 byte words, the table size is a multiple of 8
+static uint64_t hashTables( const uint8_t* left, const uint8_t* right, size_t size )
+{
+    uint64_t hash = FNV_OFFSET;
+    const uint8_t* tables[2] = {left, right};
+    for( const uint8_t* data : tables )
+    {
+        for( size_t i=0; i<size; i+=8 )
+        {
+            uint64_t word;
+            memcpy( &word, data+i, 8 );
+            hash ^= word;
+            hash *= FNV_PRIME;
+        }
+    }
+
+    return hash;
+}
+
+static std::string getCacheFile( int serial_number, RESOLUTION res )
+{
+    return Rectifier::getCacheDir() + "SN" + std::to_string(serial_number) + "_" + resolutionKey(res) + ".rect";
+}
+
+std::string Rectifier::getCacheDir()
+{
+    const char* home = getenv("HOME");
+    return std::string(home?home:".") + "/zed/settings/";
+}
+
+bool Rectifier::readCache( const std::string& path, int serial_number, RESOLUTION res, const uint64_t* calib_hash )
+{
+    if( res>=RESOLUTION::LAST )
+        return false;
+
+    int fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+    if( fd<0 )
+        return false;
+
+    struct stat st;
+    if( fstat(fd,&st)!=0 || static_cast<size_t>(st.st_size)<sizeof(CacheHeader) )
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close(fd); // The mapping keeps the file
+    if( addr==MAP_FAILED )
+        return false;
+
+    std::shared_ptr<uint8_t> mapping( static_cast<uint8_t*>(addr), [size](uint8_t* ptr){ munmap(ptr,size); } );
+
+    const CacheHeader* header = reinterpret_cast<const CacheHeader*>(addr);
+
+    int width = static_cast<int>(cameraResolution[static_cast<int>(res)].width);
+    int height = static_cast<int>(cameraResolution[static_cast<int>(res)].height);
+    size_t tableSize = RemapTable::getDataSize( width, height );
+    size_t offset = alignCache( sizeof(CacheHeader) );
+
+    if( memcmp(header->magic,cacheMagic,sizeof(cacheMagic))!=0 ||
+            header->version!=CACHE_VERSION ||
+            header->header_size!=sizeof(CacheHeader) ||
+            header->serial_number!=serial_number ||
+            header->resolution!=static_cast<int32_t>(res) ||
+            header->width!=width || header->height!=height ||
+            header->table_size!=tableSize ||
+            size!=offset+alignCache(tableSize)+tableSize )
+    {
+        WARNING_OUT(mVerbose,"Invalid rectification cache: " + path);
+        return false;
+    }
+
+    if( calib_hash && header->calib_hash!=*calib_hash )
+    {
+        INFO_OUT(mVerbose,"The calibration file changed, the rectification cache is outdated");
+        return false;
+    }
+
+    // The remap kernels trust the coordinates of the blocks not flagged as close to the border:
+    // a corrupted table must not be used
+    uint8_t* data = mapping.get() + offset;
+    if( hashTables( data, data+alignCache(tableSize), tableSize )!=header->table_hash )
+    {
+        WARNING_OUT(mVerbose,"Corrupted rectification cache: " + path);
+        return false;
+    }
+
+    mParams = header->params;
+    mLeftCam = header->left;
+    mRightCam = header->right;
+
+    // The tables point to the read only mapping: no copies and the pages are shared with the other processes
+    mLeftTable.attach( width, height, width, height, data, mapping );
+    mRightTable.attach( width, height, width, height, data+alignCache(tableSize), mapping );
+
+    return true;
+}
+
+bool Rectifier::writeCache( const std::string& path, int serial_number, RESOLUTION res, uint64_t calib_hash )
+{
+    // ----> Create the directory if needed
+    std::string dir = getCacheDir();
+    size_t pos = 0;
+    while( (pos=dir.find('/',pos+1))!=std::string::npos )
+    {
+        if( mkdir( dir.substr(0,pos).c_str(), 0755 )!=0 && errno!=EEXIST )
+            return false;
+    }
+    // <---- Create the directory if needed
+
+    CacheHeader header;
+    memset( static_cast<void*>(&header), 0, sizeof(header) ); // Deterministic padding bytes
+    memcpy( header.magic, cacheMagic, sizeof(cacheMagic) );
+    header.version = CACHE_VERSION;
+    header.header_size = sizeof(CacheHeader);
+    header.serial_number = serial_number;
+    header.resolution = static_cast<int32_t>(res);
+    header.width = mLeftTable.width;
+    header.height = mLeftTable.height;
+    header.calib_hash = calib_hash;
+    header.table_size = RemapTable::getDataSize( mLeftTable.width, mLeftTable.height );
+    header.table_hash = hashTables( reinterpret_cast<const uint8_t*>(mLeftTable.xy),
+                                    reinterpret_cast<const uint8_t*>(mRightTable.xy),
+                                    static_cast<size_t>(header.table_size) );
+    header.params = mParams;
+    header.left = mLeftCam;
+    header.right = mRightCam;
+
+    const std::vector<char> padding( CACHE_ALIGN, 0 );
+    size_t tableSize = static_cast<size_t>(header.table_size);
+
+    // Write a temporary file then rename it, so that the processes mapping the old file are not affected
+    std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file( tmpPath.c_str(), std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast<const char*>(&header), sizeof(header) );
+        file.write( padding.data(), alignCache(sizeof(header))-sizeof(header) );
+        file.write( reinterpret_cast<const char*>(mLeftTable.xy), tableSize );
+        file.write( padding.data(), alignCache(tableSize)-tableSize );
+        file.write( reinterpret_cast<const char*>(mRightTable.xy), tableSize );
+
+        // The buffered data is written when closing: the stream state is complete only after `close`
+        file.close();
+        if( file.fail() )
+        {
+            remove( tmpPath.c_str() );
+            return false;
+        }
+    }
+
+    if( rename( tmpPath.c_str(), path.c_str() )!=0 )
+    {
+        remove( tmpPath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+// <---- Cache
+
+Rectifier::Rectifier( int verbose )
+    : mVerbose(verbose)
+{
+}
+
+bool Rectifier::initialize( const std::string& calibration_file, RESOLUTION res )
+{
+    StereoParameters params;
+    if( !loadStereoParameters( calibration_file, res, params ) )
+    {
+        std::string msg = "Cannot load a valid calibration from " + calibration_file;
+        ERROR_OUT(mVerbose,msg);
+        mInitialized = false;
+        return false;
+    }
+
+    return initialize( params, res );
+}
+
+bool Rectifier::initialize( const std::string& calibration_file, RESOLUTION res, int serial_number )
+{
+    mInitialized = false;
+
+    uint64_t hash = 0;
+    if( !hashFile( calibration_file, hash ) )
+    {
+        std::string msg = "Cannot read the calibration file " + calibration_file;
+        ERROR_OUT(mVerbose,msg);
+        return false;
+    }
+
+    std::string path = getCacheFile( serial_number, res );
+    if( readCache( path, serial_number, res, &hash ) )
+    {
+        INFO_OUT(mVerbose,"Rectification tables loaded from " + path);
+        mInitialized = true;
+        return true;
+    }
+
+    if( !initialize( calibration_file, res ) )
+        return false;
+
+    if( !writeCache( path, serial_number, res, hash ) )
+    {
+        WARNING_OUT(mVerbose,"Cannot write the rectification cache " + path);
+    }
+
+    return true;
+}
+
+bool Rectifier::loadFromCache( int serial_number, RESOLUTION res )
+{
+    mInitialized = false;
+
+    if( res>=RESOLUTION::LAST )
+    {
+        ERROR_OUT(mVerbose,"Invalid resolution");
+        return false;
+    }
+
+    std::string path = getCacheFile( serial_number, res );
+    if( !readCache( path, serial_number, res, nullptr ) )
+    {
+        std::string msg = "No rectification cache for the camera SN" + std::to_string(serial_number);
+        ERROR_OUT(mVerbose,msg);
+        return false;
+    }
+
+    mInitialized = true;
+    return true;
+}
+
+bool Rectifier::initialize( const StereoParameters& params, RESOLUTION res )
+{
+    mInitialized = false;
+
+    if( !validateStereoParameters( params, res ) )
+    {
+        ERROR_OUT(mVerbose,"Invalid stereo calibration");
+        return false;
+    }
+
+    int width = static_cast<int>(cameraResolution[static_cast<int>(res)].width);
+    int height = static_cast<int>(cameraResolution[static_cast<int>(res)].height);
+
+    mParams = params;
+    stereoRectify( width, height );
+    if( !buildTable( mParams.left, mLeftCam, width, height, mLeftTable ) ||
+            !buildTable( mParams.right, mRightCam, width, height, mRightTable ) )
+    {
+        mLeftTable = RemapTable();
+        mRightTable = RemapTable();
+        return false;
+    }
+
+    mInitialized = true;
+    return true;
+}
+
+void Rectifier::stereoRectify( int width, int height )
+{
+    const CameraParameters* cams[2] = {&mParams.left, &mParams.right};
+    RectifiedCamera* rects[2] = {&mLeftCam, &mRightCam};
+
+    const double T[3] = {mParams.baseline, mParams.ty, mParams.tz};
+
+    // ----> Rotate each camera by half of the relative rotation
+    const double halfRot[3] = {-0.5*mParams.rx, -0.5*mParams.ry, -0.5*mParams.rz};
+    double rr[9];
+    rodrigues( halfRot, rr );
+
+    double t[3];
+    matVec( rr, T, t );
+    // <---- Rotate each camera by half of the relative rotation
+
+    // ----> Align the baseline with the image rows
+    int idx = (fabs(t[0])>fabs(t[1]))?0:1;
+    double c = t[idx];
+    double nt = sqrt( t[0]*t[0] + t[1]*t[1] + t[2]*t[2] );
+
+    double uu[3] = {0,0,0};
+    uu[idx] = (c>0)?1:-1;
+
+    double ww[3] = { t[1]*uu[2]-t[2]*uu[1], t[2]*uu[0]-t[0]*uu[2], t[0]*uu[1]-t[1]*uu[0] };
+    double nw = sqrt( ww[0]*ww[0] + ww[1]*ww[1] + ww[2]*ww[2] );
+    if( nw>0.0 )
+    {
+        double scale = acos( fabs(c)/nt )/nw;
+        for( int i=0; i<3; i++ )
+            ww[i] *= scale;
+    }
+
+    double wR[9];
+    rodrigues( ww, wR );
+
+    matMulTransposed( wR, rr, mLeftCam.R );
+    matMul( wR, rr, mRightCam.R );
+    matVec( mRightCam.R, T, t );
+    // <---- Align the baseline with the image rows
+
+    // ----> Common focal length and principal points centering the image corners
+    double fc = 0.5*( (idx==0?cams[0]->fy:cams[0]->fx) + (idx==0?cams[1]->fy:cams[1]->fx) );
+    double cc[2][2];
+
+    for( int k=0; k<2; k++ )
+    {
+        double avg[2] = {0,0};
+        for( int i=0; i<4; i++ )
+        {
+            double x, y;
+            undistortPoint( *cams[k], (i%2)*(width-1), (i/2)*(height-1), x, y );
+
+            const double pt[3] = {x, y, 1.0};
+            double r[3];
+            matVec( rects[k]->R, pt, r );
+            avg[0] += 0.25*fc*r[0]/r[2];
+            avg[1] += 0.25*fc*r[1]/r[2];
+        }
+
+        // Integer image center, as OpenCV does
+        cc[k][0] = (width-1)/2 - avg[0];
+        cc[k][1] = (height-1)/2 - avg[1];
+    }
+
+    // Zero disparity at infinity: same principal point for both cameras
+    for( int i=0; i<2; i++ )
+        cc[0][i] = cc[1][i] = 0.5*(cc[0][i]+cc[1][i]);
+    // <---- Common focal length and principal points centering the image corners
+
+    for( int k=0; k<2; k++ )
+    {
+        double* P = rects[k]->P;
+        std::fill( P, P+12, 0.0 );
+        P[0] = P[5] = fc;
+        P[2] = cc[k][0];
+        P[6] = cc[k][1];
+        P[10] = 1.0;
+    }
+    mRightCam.P[4*idx+3] = t[idx]*fc;
+
+    // ----> Scale to keep only valid pixels (alpha=0)
+    double inner[2][4], outer[2][4];
+    getRectangles( mParams.left, mLeftCam, width, height, inner[0], outer[0] );
+    getRectangles( mParams.right, mRightCam, width, height, inner[1], outer[1] );
+
+    double s = 0.0;
+    for( int k=0; k<2; k++ )
+    {
+        double cx = cc[k][0];
+        double cy = cc[k][1];
+        s = std::max( s, cx/(cx-inner[k][0]) );
+        s = std::max( s, cy/(cy-inner[k][1]) );
+        s = std::max( s, (width-cx)/(inner[k][2]-cx) );
+        s = std::max( s, (height-cy)/(inner[k][3]-cy) );
+    }
+
+    for( int k=0; k<2; k++ )
+    {
+        rects[k]->P[0] *= s;
+        rects[k]->P[5] *= s;
+    }
+    mRightCam.P[4*idx+3] *= s;
+    // <---- Scale to keep only valid pixels (alpha=0)
+}
+
+bool Rectifier::buildTable( const CameraParameters& cam, const RectifiedCamera& rect, int width, int height,
+                            RemapTable& table )
+{
+    // ----> Inverse of the rectified projection and rotation
+    const double Pr[9] = { rect.P[0], rect.P[1], rect.P[2], rect.P[4], rect.P[5], rect.P[6], rect.P[8], rect.P[9], rect.P[10] };
+    double PR[9], iR[9];
+    matMul( Pr, rect.R, PR );
+    if( !matInvert( PR, iR ) )
+    {
+        ERROR_OUT(mVerbose,"Degenerate rectification");
+        return false;
+    }
+    // <---- Inverse of the rectified projection and rotation
+
+    table.create( width, height, width, height );
+
+    for( int v=0; v<height; v++ )
+    {
+        double _x = v*iR[1] + iR[2];
+        double _y = v*iR[4] + iR[5];
+        double _w = v*iR[7] + iR[8];
+
+        for( int u=0; u<width; u++, _x+=iR[0], _y+=iR[3], _w+=iR[6] )
+        {
+            double w = 1.0/_w;
+            double x = _x*w;
+            double y = _y*w;
+
+            double x2 = x*x, y2 = y*y, r2 = x2+y2, _2xy = 2*x*y;
+            double kr = 1 + ((cam.k3*r2 + cam.k2)*r2 + cam.k1)*r2;
+            double srcX = cam.fx*(x*kr + cam.p1*_2xy + cam.p2*(r2+2*x2)) + cam.cx;
+            double srcY = cam.fy*(y*kr + cam.p1*(r2+2*y2) + cam.p2*_2xy) + cam.cy;
+
+            table.set( u, v, static_cast<float>(srcX), static_cast<float>(srcY) );
+        }
+    }
+
+    return true;
+}
+
+bool Rectifier::rectify( const ImageView& left, const ImageView& right, uint8_t* left_dst, uint8_t* right_dst, int threads )
+{
+    if( !mInitialized )
+        return false;
+
+    return remapImage( left, mLeftTable, left_dst, static_cast<size_t>(mLeftTable.width)*left.channels, threads ) &&
+            remapImage( right, mRightTable, right_dst, static_cast<size_t>(mRightTable.width)*right.channels, threads );
+}
+
+bool Rectifier::rectify( const Frame& frame, uint8_t* left_dst, uint8_t* right_dst, COLOR_FORMAT format, int threads )
+{
+    if( !mInitialized || frame.channels!=2 )
+        return false;
+
+    StereoView views = splitStereo( frame );
+    size_t step = static_cast<size_t>(mLeftTable.width)*getColorFormatChannels(format);
+
+    return remapYUYV( views.left, mLeftTable, left_dst, step, format, threads ) &&
+            remapYUYV( views.right, mRightTable, right_dst, step, format, threads );
+}
+
+}
+
+}
@@ -19,6 +19,7 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "sensorcapture.hpp"
+#include "deviceregistry.hpp"
 
 #ifdef VIDEO_MOD_AVAILABLE
 
@@ -53,7 +54,7 @@ SensorCapture::~SensorCapture()
     reset();
 }
 
-int SensorCapture::enumerateDevices()
+int SensorCapture::enumerateDevices( bool refresh )
 {
     mSlDevPid.clear();
     mSlDevFwVer.clear();
@@ -63,6 +64,42 @@ int SensorCapture::enumerateDevices()
     if (hid_init()==-1)
         return 0;
 
+    // ----> Sensors MCUs from the device registry
+    // The cached list is scanned again if it contains no sensors MCU, e.g. a camera just connected
+    for( int attempt=(refresh?1:0); attempt<2 && mSlDevPid.empty(); attempt++ )
+    {
+        std::vector<CameraDevice> cameras = DeviceRegistry::instance().getDevices( attempt>0 );
+        for( const CameraDevice& cam : cameras )
+        {
+            if( cam.mcu_pid==0 || cam.serial_number==-1 )
+                continue;
+
+            mSlDevPid[cam.serial_number]=cam.mcu_pid;
+            mSlDevFwVer[cam.serial_number]=cam.mcu_fw_version;
+
+            if(mVerbose)
+            {
+                std::ostringstream smsg;
+
+                smsg << "Device Found: " << std::endl;
+                smsg << "  Model: " << cam.model << std::endl;
+                smsg << "  VID: " << std::hex << SL_USB_VENDOR << " PID: " << std::hex << cam.mcu_pid << std::endl;
+                smsg << "  Path: " << cam.hidraw_dev << std::endl;
+                smsg << "  Serial_number:   " << std::dec << cam.serial_number << std::endl;
+                smsg << "  Video device:   " << (cam.video_dev.empty()?"not found":cam.video_dev) << std::endl;
+                smsg << "  Release number:   v" << (cam.mcu_fw_version>>8) << "." << (cam.mcu_fw_version&0x00FF) << std::endl;
+                smsg << "***" << std::endl;
+
+                INFO_OUT(mVerbose,smsg.str());
+            }
+        }
+    }
+
+    if( mSlDevPid.size()>0 )
+        return mSlDevPid.size();
+    // <---- Sensors MCUs from the device registry
+
+    // sysfs not available: enumerate the HID devices
     devs = hid_enumerate(SL_USB_VENDOR, 0x0);
     cur_dev = devs;
     while (cur_dev) {
@@ -123,7 +160,13 @@ bool SensorCapture::initializeSensors( int sn )
     std::string sn_str;
 
     if(sn!=-1)
+    {
+        // A camera connected after the last scan requires a new scan
+        if(mSlDevPid.find(sn)==mSlDevPid.end())
+            enumerateDevices(true);
+
         sn_str = std::to_string(sn);
+    }
     else
     {
         if(mSlDevPid.size()==0)
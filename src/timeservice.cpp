@@ -0,0 +1,178 @@
+﻿///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+
+#include "timeservice.hpp"
+
+#include <cmath>
+
+namespace sl_oc {
+
+TimeService::TimeService( size_t block_size, size_t window )
+{
+    mBlockSize = (block_size>0)?block_size:1;
+    mWindow = (window>2)?window:3;
+}
+
+void TimeService::addSample( int clock_id, uint64_t device_ts, uint64_t host_ts )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    ClockState& state = mClocks[clock_id];
+    state.estimate.samples++;
+
+    // ----> Minimum offset of the block: the sample with the lowest latency
+    OffsetPoint point;
+    point.device_ts = device_ts;
+    point.offset = static_cast<int64_t>(host_ts-device_ts);
+
+    if( state.block_count==0 || point.offset<state.block_min.offset )
+        state.block_min = point;
+
+    if( ++state.block_count < mBlockSize )
+        return;
+    // <---- Minimum offset of the block: the sample with the lowest latency
+
+    // A device restart resets its clock: the previous points are not valid anymore
+    if( !state.points.empty() && state.block_min.device_ts<=state.points.back().device_ts )
+        state.points.clear();
+
+    state.points.push_back(state.block_min);
+    if( state.points.size()>mWindow )
+        state.points.pop_front();
+
+    state.block_count = 0;
+
+    fitLocked(state);
+}
+
+void TimeService::fitLocked( ClockState& state )
+{
+    ClockEstimate& est = state.estimate;
+    const OffsetPoint& newest = state.points.back();
+    size_t n = state.points.size();
+
+    est.ref_ts = newest.device_ts;
+    est.offset = newest.offset;
+    est.drift_ppm = 0.0;
+    est.offset_stddev = 0.0;
+    est.drift_stddev = 0.0;
+    est.residual_rms = 0.0;
+    est.valid = false;
+
+    if( n<3 )
+        return;
+
+    // ----> Least squares fit of the offset, relative to the newest point for precision
+    double xm = 0.0, ym = 0.0;
+    for( const OffsetPoint& pt : state.points )
+    {
+        xm += static_cast<double>(static_cast<int64_t>(pt.device_ts-newest.device_ts));
+        ym += static_cast<double>(pt.offset-newest.offset);
+    }
+    xm /= n;
+    ym /= n;
+
+    double sxx = 0.0, sxy = 0.0;
+    for( const OffsetPoint& pt : state.points )
+    {
+        double dx = static_cast<double>(static_cast<int64_t>(pt.device_ts-newest.device_ts)) - xm;
+        double dy = static_cast<double>(pt.offset-newest.offset) - ym;
+        sxx += dx*dx;
+        sxy += dx*dy;
+    }
+
+    if( sxx<=0.0 )
+        return;
+
+    double drift = sxy/sxx;
+    double offset = ym - drift*xm;
+
+    double ssr = 0.0;
+    for( const OffsetPoint& pt : state.points )
+    {
+        double x = static_cast<double>(static_cast<int64_t>(pt.device_ts-newest.device_ts));
+        double r = static_cast<double>(pt.offset-newest.offset) - (offset + drift*x);
+        ssr += r*r;
+    }
+    // <---- Least squares fit of the offset, relative to the newest point for precision
+
+    double s2 = ssr/(n-2);
+
+    est.offset = newest.offset + static_cast<int64_t>(std::llround(offset));
+    est.drift_ppm = drift*1e6;
+    est.offset_stddev = std::sqrt( s2*(1.0/n + xm*xm/sxx) );
+    est.drift_stddev = std::sqrt( s2/sxx )*1e6;
+    est.residual_rms = std::sqrt( ssr/n );
+    est.valid = true;
+}
+
+bool TimeService::getEstimate( int clock_id, ClockEstimate& estimate )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    std::map<int,ClockState>::iterator it = mClocks.find(clock_id);
+    if( it==mClocks.end() )
+        return false;
+
+    estimate = it->second.estimate;
+    return !it->second.points.empty();
+}
+
+uint64_t TimeService::toHostTime( int clock_id, uint64_t device_ts )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    std::map<int,ClockState>::iterator it = mClocks.find(clock_id);
+    if( it==mClocks.end() || it->second.points.empty() )
+        return device_ts;
+
+    const ClockEstimate& est = it->second.estimate;
+    double dt = static_cast<double>(static_cast<int64_t>(device_ts-est.ref_ts));
+
+    return device_ts + est.offset + static_cast<int64_t>(std::llround(est.drift_ppm*1e-6*dt));
+}
+
+uint64_t TimeService::toDeviceTime( int clock_id, uint64_t host_ts )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    std::map<int,ClockState>::iterator it = mClocks.find(clock_id);
+    if( it==mClocks.end() || it->second.points.empty() )
+        return host_ts;
+
+    // host = device + offset + drift*(device-ref) => device = ref + (host-offset-ref)/(1+drift)
+    const ClockEstimate& est = it->second.estimate;
+    double dt = static_cast<double>(static_cast<int64_t>(host_ts-est.offset-est.ref_ts));
+
+    return est.ref_ts + static_cast<int64_t>(std::llround(dt/(1.0+est.drift_ppm*1e-6)));
+}
+
+void TimeService::reset( int clock_id )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    if( clock_id==-1 )
+        mClocks.clear();
+    else
+        mClocks.erase(clock_id);
+}
+
+}
@@ -19,6 +19,8 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "videocapture.hpp"
+#include "deviceregistry.hpp"
+#include "imageconversion.hpp"
 
 #ifdef SENSORS_MOD_AVAILABLE
 #include "sensorcapture.hpp"
@@ -28,17 +30,22 @@
 #include <errno.h>            // for errno, EBADRQC, EINVAL, ENOBUFS, ENOENT
 #include <fcntl.h>            // for open, O_NONBLOCK, O_RDONLY, O_RDWR
 #include <unistd.h>           // for usleep, close
+#include <stdlib.h>           // for calloc, free
 
 #include <linux/usb/video.h>  // for UVC_GET_CUR, UVC_SET_CUR, UVC_GET_LEN
 #include <linux/uvcvideo.h>   // for uvc_xu_control_query, UVCIOC_CTRL_QUERY
 #include <linux/videodev2.h>  // for v4l2_buffer, v4l2_queryctrl, V4L2_BUF_T...
 #include <sys/mman.h>         // for mmap, munmap, MAP_SHARED, PROT_READ
 #include <sys/ioctl.h>        // for ioctl
+#include <sys/epoll.h>        // for epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>      // for eventfd
 
 #include <sstream>
 #include <fstream>            // for char_traits, basic_istream::operator>>
 
 #include <cmath>              // for round
+#include <deque>
+#include <algorithm>          // for lower_bound
 
 
 #define READ_MODE   1
@@ -106,14 +113,38 @@
 #define EXP_RAW_MIN         2
 // <---- Camera Control
 
+// ----> Frame pyramid
+#define PYRAMID_MAX_LEVELS  6
+#define PYRAMID_ALIGN       64 // Cache line size
+// <---- Frame pyramid
+
 
 namespace sl_oc {
 
 namespace video {
 
+/*!
+ * \brief Internal status of a frame subscriber
+ */
+struct VideoCapture::Subscriber
+{
+    FrameCallback callback;             //!< The subscriber callback
+    SubscriberOptions options;          //!< The subscriber options
+    SubscriberStats stats;              //!< The subscriber statistics
+    uint64_t frameCount = 0;            //!< Number of frames grabbed since the subscription, used for decimation
+
+    std::deque<FrameLease> queue;       //!< Frames waiting for the callback
+    bool busy = false;                  //!< Indicates if the callback is running
+    bool stop = false;                  //!< Indicates if the subscriber thread must be stopped
+    std::mutex mutex;                   //!< Mutex for safe access to the queue
+    std::condition_variable cond;       //!< Signals queue and status changes
+
+    std::thread thread;                 //!< The callback thread
+};
+
 VideoCapture::VideoCapture(VideoParams params)
 {
-    memcpy( &mParams, &params, sizeof(VideoParams) );
+    mParams = params;
 
     if( mParams.verbose )
     {
@@ -144,19 +175,59 @@ VideoCapture::VideoCapture(VideoParams params)
 
 VideoCapture::~VideoCapture()
 {
+    stopControlThread();
+
     reset();
+
+    // ----> Stop the subscribers
+    std::vector<int> ids;
+    mSubMutex.lock();
+    for( auto& sub : mSubscribers )
+        ids.push_back(sub.first);
+    mSubMutex.unlock();
+
+    for( int id : ids )
+        unsubscribe(id);
+    // <---- Stop the subscribers
 }
 
 void VideoCapture::reset()
 {
+    // The control thread must not use the device while it is closed and opened again:
+    // the pending commands fail and the thread is restarted by a successful initialization
+    stopControlThread();
+
     setLEDstatus( false );
+    invalidateControlCache();
+    mSerialNumber = -1;
+
+    mRangeMutex.lock();
+    mCtrlRanges.clear();
+    mRangeMutex.unlock();
 
     mStopCapture = true;
 
+    // Wake up the threads waiting for a frame
+    mBufMutex.lock();
+    mBufMutex.unlock();
+    mFrameCond.notify_all();
+
+    wakeGrabThread();
+
     if( mGrabThread.joinable() )
     {
         mGrabThread.join();
     }
+    mGrabRunning = false;
+
+    // Leases must be released before unmapping the buffers
+    flushSubscribers();
+
+    if( mEventFd != -1 )
+    {
+        close(mEventFd);
+        mEventFd = -1;
+    }
 
     // ----> Stop capturing
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -168,12 +239,30 @@ void VideoCapture::reset()
     if( mInitialized && mBuffers)
     {
         for (unsigned int i = 0; i < mBufCount; ++i)
-            munmap(mBuffers[i].start, mBuffers[i].length);
+        {
+            if (mBuffers[i].dmabuf_fd != -1)
+                close(mBuffers[i].dmabuf_fd);
+            if (mBufMemory==BUFFER_MEMORY::MMAP || mOwnUserBuffers)
+                munmap(mBuffers[i].start, mBuffers[i].length);
+        }
         if (mBuffers)
             free(mBuffers);
 
         mBuffers = nullptr;
     }
+
+    mBufFrames.clear();
+    mBufRefCount.clear();
+    mRing.clear();
+    mRingHead = 0;
+    mRingCount = 0;
+    mStats = CaptureStats();
+
+    mHistMutex.lock();
+    mHistorySlots.clear();
+    mHistory.clear();
+    mHistoryFree.clear();
+    mHistMutex.unlock();
     // <---- deinit device
 
     if (mFileDesc)
@@ -187,6 +276,8 @@ void VideoCapture::reset()
         delete [] mLastFrame.data;
         mLastFrame.data = nullptr;
     }
+    mLastFrame.pyramid = nullptr;
+    mLastPyramid = FramePyramid();
 
     if( mParams.verbose && mInitialized)
     {
@@ -280,11 +371,31 @@ bool VideoCapture::initializeVideo( int devId/*=-1*/ )
 
     if( devId==-1 )
     {
-        // Try to open all the devices until the first success (max allowed by v4l: 64)
-        for( uint8_t id=0; id<64; id++ )
+        if( access("/sys/class/video4linux", F_OK)==0 )
+        {
+            // Try only the ZED video devices, scanning them again if the cached ones cannot be opened
+            for( int attempt=0; attempt<2 && !opened; attempt++ )
+            {
+                std::vector<VideoDeviceInfo> devs = enumerate( attempt>0 );
+                for( const VideoDeviceInfo& dev : devs )
+                {
+                    opened = openCamera( static_cast<uint8_t>(dev.id) );
+                    if(opened)
+                    {
+                        mSerialNumber = dev.serial_number;
+                        break;
+                    }
+                }
+            }
+        }
+        else
         {
-            opened = openCamera( id );
-            if(opened) break;
+            // Try to open all the devices until the first success (max allowed by v4l: 64)
+            for( uint8_t id=0; id<64; id++ )
+            {
+                opened = openCamera( id );
+                if(opened) break;
+            }
         }
     }
     else
@@ -307,18 +418,111 @@ bool VideoCapture::initializeVideo( int devId/*=-1*/ )
 
     setLEDstatus( true );
 
-    resetAECAGC();
-    resetAutoWhiteBalance();
-    resetBrightness();
-    resetContrast();
-    resetGamma();
-    resetHue();
-    resetSaturation();
-    resetSharpness();
+    // The getters use the multi-register reads only if the firmware supports them
+    ll_probe_sensor_burst();
+
+    applySettingsProfile( getDefaultSettingsProfile() );
+
+    if( mInitialized )
+        resumeControlThread();
 
     return mInitialized;
 }
 
+bool VideoCapture::initializeVideoBySerial( int sn )
+{
+    // A camera connected after the last scan requires a new scan
+    std::vector<VideoDeviceInfo> devs = enumerate();
+    if( std::none_of( devs.begin(), devs.end(), [sn](const VideoDeviceInfo& dev) {return dev.serial_number==sn;} ) )
+        devs = enumerate( true );
+
+    // ----> Serial number available from the USB descriptor
+    for( const VideoDeviceInfo& dev : devs )
+    {
+        if( dev.serial_number==sn )
+        {
+            if( !initializeVideo(dev.id) )
+                return false;
+
+            mSerialNumber = sn;
+            return true;
+        }
+    }
+    // <---- Serial number available from the USB descriptor
+
+    // ----> Serial number read from the camera
+    for( const VideoDeviceInfo& dev : devs )
+    {
+        if( dev.serial_number!=-1 )
+            continue;
+
+        if( initializeVideo(dev.id) && getSerialNumber()==sn )
+            return true;
+    }
+    // <---- Serial number read from the camera
+
+    reset();
+
+    if(mParams.verbose)
+    {
+        std::string msg = "Camera with serial number " + std::to_string(sn) + " not found";
+        ERROR_OUT(mParams.verbose,msg);
+    }
+
+    return false;
+}
+
+std::vector<VideoDeviceInfo> VideoCapture::enumerate( bool refresh )
+{
+    std::vector<VideoDeviceInfo> devs;
+
+    // The cached list is scanned again if it contains no video device, e.g. a camera just connected
+    for( int attempt=(refresh?1:0); attempt<2 && devs.empty(); attempt++ )
+    {
+        std::vector<CameraDevice> cameras = DeviceRegistry::instance().getDevices( attempt>0 );
+        for( const CameraDevice& cam : cameras )
+        {
+            if( cam.video_id==-1 )
+                continue;
+
+            VideoDeviceInfo info;
+            switch( cam.video_pid )
+            {
+            case SL_USB_PROD_ZED_REVA:
+                info.model = SL_DEVICE::ZED;
+                break;
+            case SL_USB_PROD_ZED_M_REVA:
+                info.model = SL_DEVICE::ZED_M;
+                break;
+            case SL_USB_PROD_ZED_REVB:
+                info.model = SL_DEVICE::ZED_CBS;
+                break;
+            case SL_USB_PROD_ZED_M_REVB:
+                info.model = SL_DEVICE::ZED_M_CBS;
+                break;
+            case SL_USB_PROD_ZED_2_REVB:
+                info.model = SL_DEVICE::ZED_2;
+                break;
+            default:
+                continue;
+            }
+
+            info.id = cam.video_id;
+            info.dev_name = cam.video_dev;
+            info.usb_path = cam.video_usb_path;
+            info.serial_number = cam.serial_number;
+
+            devs.push_back(info);
+        }
+    }
+
+    std::sort( devs.begin(), devs.end(), [](const VideoDeviceInfo& a, const VideoDeviceInfo& b) {
+        return a.id < b.id;
+    });
+
+    return devs;
+}
+
 bool VideoCapture::openCamera( uint8_t devId )
 {
     mDevId = devId;
@@ -458,6 +662,7 @@ bool VideoCapture::openCamera( uint8_t devId )
     mWidth = fmt.fmt.pix.width;
     mHeight = fmt.fmt.pix.height;
     mChannels = fmt.fmt.pix.bytesperline / mWidth;
+    mFrameSize = fmt.fmt.pix.sizeimage;
 
     // Asked resolution not available, exiting
     if (mWidth != width_tmp || mHeight != height_tmp)
@@ -474,18 +679,33 @@ bool VideoCapture::openCamera( uint8_t devId )
     // ----> Output frame allocation
     mLastFrame.width = mWidth;
     mLastFrame.height = mHeight;
-    mLastFrame.channels = mChannels;
-    int bufSize = mLastFrame.width * mLastFrame.height * mLastFrame.channels;
-    mLastFrame.data = new unsigned char[bufSize];
+    mLastFrame.channels = (mParams.output_format==OUTPUT_FORMAT::GRAY)?1:mChannels;
+    mLastFrame.data = new unsigned char[getOutputFrameSize()];
+    allocatePyramid(mLastPyramid);
+    mLastFrame.pyramid = mLastPyramid.memory?&mLastPyramid:nullptr;
     // <---- Output frame allocation
 
     struct v4l2_requestbuffers req;
     memset(&req, 0, sizeof (v4l2_requestbuffers));
 
+    mBufMemory = mParams.buffer_memory;
+    if( mBufMemory==BUFFER_MEMORY::USERPTR && mParams.export_dmabuf )
+    {
+        WARNING_OUT(mParams.verbose,"DMABUF export is not available with USERPTR buffers");
+    }
+
+    mBufCount = mParams.buffer_count;
+    if( mBufMemory==BUFFER_MEMORY::USERPTR && !mUserBuffers.empty() )
+        mBufCount = static_cast<uint8_t>(std::min<size_t>(mUserBuffers.size(),32));
+    if( mBufCount < 2 )
+        mBufCount = 2;
+    if( mBufCount > 32 )
+        mBufCount = 32;
+
     req.count = mBufCount;
 
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_MMAP;
+    req.memory = (mBufMemory==BUFFER_MEMORY::USERPTR)?V4L2_MEMORY_USERPTR:V4L2_MEMORY_MMAP;
     if( -1==xioctl(mFileDesc, VIDIOC_REQBUFS, &req) )
     {
         if(mParams.verbose)
@@ -500,48 +720,257 @@ bool VideoCapture::openCamera( uint8_t devId )
 
     // Create buffers
     mBuffers = (UVCBuffer*) calloc(req.count, sizeof(*mBuffers));
+    for(unsigned int i = 0; i < req.count; ++i)
+        mBuffers[i].dmabuf_fd = -1;
 
-    for(mBufCount = 0; mBufCount < req.count; ++mBufCount)
+    if( mBufMemory==BUFFER_MEMORY::USERPTR )
     {
-        struct v4l2_buffer buf;
-        memset(&buf, 0, sizeof (v4l2_buffer));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = mBufCount;
-        buf.flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
-        if( -1==xioctl(mFileDesc, VIDIOC_QUERYBUF, &buf))
+        if( !createUserBuffers(req.count, fmt.fmt.pix.sizeimage) )
+        {
+            free(mBuffers);
+            mBuffers = nullptr;
+            return false;
+        }
+    }
+    else
+    {
+        for(mBufCount = 0; mBufCount < req.count; ++mBufCount)
+        {
+            struct v4l2_buffer buf;
+            memset(&buf, 0, sizeof (v4l2_buffer));
+            buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            buf.memory = V4L2_MEMORY_MMAP;
+            buf.index = mBufCount;
+            buf.flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+            if( -1==xioctl(mFileDesc, VIDIOC_QUERYBUF, &buf))
+            {
+                if(mParams.verbose)
+                {
+                    std::string msg = std::string("Cannot query buffer for '") + mDevName + "': ["
+                            + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
+                    ERROR_OUT(mParams.verbose,msg);
+                }
+
+                return false;
+            }
+
+            mBuffers[mBufCount].length = buf.length;
+
+            mBuffers[mBufCount].start =
+                    mmap(nullptr /* start anywhere */,
+                         buf.length,
+                         PROT_READ | PROT_WRITE /* required */,
+                         MAP_SHARED /* recommended */,
+                         mFileDesc, buf.m.offset);
+
+            if( mParams.export_dmabuf )
+            {
+                struct v4l2_exportbuffer expbuf;
+                memset(&expbuf, 0, sizeof (v4l2_exportbuffer));
+                expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                expbuf.index = mBufCount;
+                expbuf.flags = O_RDONLY | O_CLOEXEC;
+                if( -1==xioctl(mFileDesc, VIDIOC_EXPBUF, &expbuf))
+                {
+                    if(mParams.verbose)
+                    {
+                        std::string msg = std::string("Cannot export buffer as DMABUF for '") + mDevName + "': ["
+                                + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
+                        WARNING_OUT(mParams.verbose,msg);
+                    }
+                }
+                else
+                {
+                    mBuffers[mBufCount].dmabuf_fd = expbuf.fd;
+                }
+            }
+        }
+    }
+
+    mBufCount = req.count;
+
+    // ----> Buffer information
+    mBufFrames.resize(mBufCount);
+    mBufRefCount.assign(mBufCount,0);
+    for(unsigned int i = 0; i < mBufCount; ++i)
+    {
+        mBufFrames[i].data = static_cast<uint8_t*>(mBuffers[i].start);
+        mBufFrames[i].width = mWidth;
+        mBufFrames[i].height = mHeight;
+        mBufFrames[i].channels = mChannels;
+        mBufFrames[i].dmabuf_fd = mBuffers[i].dmabuf_fd;
+        mBufFrames[i].dmabuf_size = mBuffers[i].dmabuf_fd!=-1?mBuffers[i].length:0;
+    }
+    // <---- Buffer information
+
+    // ----> Frame ring
+    // With the "latest" policy only the freshest frame is kept, else one buffer is always left to the driver
+    size_t ringSize = (mParams.ring_policy==RING_POLICY::LATEST)?1:(mBufCount-1);
+    mRing.assign(ringSize,-1);
+    mRingHead = 0;
+    mRingCount = 0;
+    // <---- Frame ring
+
+    createHistory();
+    // <---- Init
+
+    return true;
+}
+
+bool VideoCapture::registerUserBuffers( const std::vector<void*>& buffers, size_t length )
+{
+    if( mInitialized )
+    {
+        ERROR_OUT(mParams.verbose,"The user buffers must be registered before opening the camera");
+        return false;
+    }
+
+    if( buffers.size() < 2 || length == 0 )
+    {
+        ERROR_OUT(mParams.verbose,"At least two valid user buffers are required");
+        return false;
+    }
+
+    for( void* ptr : buffers )
+    {
+        if( ptr == nullptr )
+        {
+            ERROR_OUT(mParams.verbose,"Invalid user buffer");
+            return false;
+        }
+    }
+
+    mUserBuffers = buffers;
+    mUserBufferLength = length;
+
+    return true;
+}
+
+size_t VideoCapture::getRequiredBufferSize( RESOLUTION res )
+{
+    const Resolution& camRes = cameraResolution[static_cast<int>(res)];
+
+    // Side-by-side YUV 4:2:2 frames
+    return camRes.width * 2 * camRes.height * 2;
+}
+
+bool VideoCapture::createUserBuffers( unsigned int count, size_t size )
+{
+    mOwnUserBuffers = mUserBuffers.empty();
+
+    // ----> Application buffers
+    if( !mOwnUserBuffers )
+    {
+        if( count > mUserBuffers.size() || mUserBufferLength < size )
+        {
+            std::string msg = std::string("The registered user buffers are not enough: ") + std::to_string(count) +
+                    std::string(" buffers of ") + std::to_string(size) + std::string(" bytes are required");
+            ERROR_OUT(mParams.verbose,msg);
+            return false;
+        }
+
+        for( unsigned int i = 0; i < count; ++i )
+        {
+            mBuffers[i].start = mUserBuffers[i];
+            mBuffers[i].length = mUserBufferLength;
+        }
+
+        return true;
+    }
+    // <---- Application buffers
+
+    // ----> Library buffers
+    const size_t hugePageSize = 2*1024*1024;
+    size_t align = mParams.use_hugepages?hugePageSize:static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t length = ((size+align-1)/align)*align;
+
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        void* ptr = MAP_FAILED;
+
+        if( mParams.use_hugepages )
+        {
+#ifdef MAP_HUGETLB
+            ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+            if( ptr == MAP_FAILED )
+            {
+                if( i==0 )
+                {
+                    WARNING_OUT(mParams.verbose,"Hugepages not available (see /proc/sys/vm/nr_hugepages), using transparent hugepages");
+                }
+
+                ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+                if( ptr != MAP_FAILED )
+                    madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+            }
+        }
+        else
+        {
+            ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+
+        if( ptr == MAP_FAILED )
         {
             if(mParams.verbose)
             {
-                std::string msg = std::string("Cannot query buffer for '") + mDevName + "': ["
+                std::string msg = std::string("Cannot allocate user buffer: [")
                         + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
                 ERROR_OUT(mParams.verbose,msg);
             }
 
+            for( unsigned int j = 0; j < i; ++j )
+                munmap(mBuffers[j].start, mBuffers[j].length);
+
             return false;
         }
 
-        mBuffers[mBufCount].length = buf.length;
+        if( mParams.lock_memory && mlock(ptr, length) != 0 )
+        {
+            if(mParams.verbose)
+            {
+                std::string msg = std::string("Cannot lock user buffer in memory: [")
+                        + std::to_string(errno) +std::string("] ") + std::string(strerror(errno));
+                WARNING_OUT(mParams.verbose,msg);
+            }
+        }
 
-        mBuffers[mBufCount].start =
-                mmap(nullptr /* start anywhere */,
-                     buf.length,
-                     PROT_READ | PROT_WRITE /* required */,
-                     MAP_SHARED /* recommended */,
-                     mFileDesc, buf.m.offset);
+        mBuffers[i].start = ptr;
+        mBuffers[i].length = length;
     }
-
-    mBufCount = req.count;
-    // <---- Init
+    // <---- Library buffers
 
     return true;
 }
 
+void VideoCapture::initV4l2Buffer( ::v4l2_buffer& buf, int index )
+{
+    memset(&buf, 0, sizeof (buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.index = index;
+
+    if( mBufMemory==BUFFER_MEMORY::USERPTR )
+    {
+        buf.memory = V4L2_MEMORY_USERPTR;
+        buf.m.userptr = reinterpret_cast<unsigned long>(mBuffers[index].start);
+        buf.length = mBuffers[index].length;
+    }
+    else
+    {
+        buf.memory = V4L2_MEMORY_MMAP;
+    }
+}
+
 int VideoCapture::getSerialNumber()
 {
     if(!mInitialized)
         return -1;
 
+    if(mSerialNumber!=-1)
+        return mSerialNumber;
+
     int ulValue = -1;
 
     uint8_t UNIQUE_BUF[384];
@@ -584,7 +1013,8 @@ int VideoCapture::getSerialNumber()
     char buff[128];
     memset(buff, 0, 128);
     sprintf(buff, "%x", ulValue);
-    return (int) atoi(buff);
+    mSerialNumber = (int) atoi(buff);
+    return mSerialNumber;
 }
 
 bool VideoCapture::startCapture()
@@ -593,10 +1023,8 @@ bool VideoCapture::startCapture()
     enum v4l2_buf_type type;
     for (unsigned int i = 0; i < mBufCount; ++i)
     {
-        struct v4l2_buffer buf = {0};
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = i;
+        struct v4l2_buffer buf;
+        initV4l2Buffer(buf, i);
         if( -1==xioctl(mFileDesc, VIDIOC_QBUF, &buf) )
         {
             if(mParams.verbose)
@@ -639,6 +1067,26 @@ bool VideoCapture::startCapture()
     }
     // <---- Start capturing
 
+    // Event used to wake up the grabbing thread on stop requests
+    mEventFd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+    if( mEventFd == -1 )
+    {
+        std::string msg = std::string("Cannot create the grabbing event: ") + std::string(strerror(errno));
+        ERROR_OUT(mParams.verbose,msg);
+
+        return false;
+    }
+
+    mStopCapture = false;
+
+    if( mExternalGrab )
+    {
+        // The frames are dequeued by the thread polling `mFileDesc`, calling `grabFrames`
+        mFirstFrame=true;
+        mGrabRunning=true;
+        return true;
+    }
+
     mGrabThread = std::thread( &VideoCapture::grabThreadFunc,this );
 
     return true;
@@ -748,31 +1196,26 @@ SL_DEVICE VideoCapture::getCameraModel( std::string dev_name)
 
 void VideoCapture::grabThreadFunc()
 {
-    mNewFrame = false;
-    mStopCapture = false;
-
-    fd_set fds;
-    struct timeval tv = {0};
-
-    FD_ZERO(&fds);
-
-    if (mFileDesc < 0)
+    if (mFileDesc < 0 || mEventFd < 0)
         return;
 
-    FD_SET(mFileDesc, &fds);
-    tv.tv_sec = 2;
-    tv.tv_usec = 0;
-    select(mFileDesc + 1, &fds, nullptr, nullptr, &tv);
-
-    struct v4l2_buffer buf;
-    memset(&(buf), 0, sizeof (buf));
-    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP;
-    buf.bytesused = -1;
-    buf.length = 0;
+    // ----> Wait for video data and control events
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if( epollFd == -1 )
+    {
+        std::string msg = std::string("Cannot create the grabbing epoll instance: ") + std::string(strerror(errno));
+        ERROR_OUT(mParams.verbose,msg);
+        return;
+    }
 
-    uint64_t rel_ts = 0;
-    int capture_frame_count = 0;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = mFileDesc;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, mFileDesc, &ev);
+    ev.data.fd = mEventFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, mEventFd, &ev);
+    // <---- Wait for video data and control events
 
     mFirstFrame=true;
 
@@ -780,104 +1223,997 @@ void VideoCapture::grabThreadFunc()
     {
         mGrabRunning=true;
 
-        mComMutex.lock();
-        int ret = ioctl(mFileDesc, VIDIOC_DQBUF, &buf);
-        mComMutex.unlock();
+        struct epoll_event events[2];
+        int n = epoll_wait(epollFd, events, 2, -1);
+        uint64_t wake_ts = getSteadyTimestamp();
 
-        if (buf.bytesused == buf.length && ret == 0 && buf.index < mBufCount)
+        if( n < 0 )
         {
-            mCurrentIndex = buf.index;
-            // get buffer timestamp in us
+            if( errno == EINTR )
+                continue;
 
-            uint64_t ts_uvc = ((uint64_t) buf.timestamp.tv_sec) * (1000 * 1000) + ((uint64_t) buf.timestamp.tv_usec);
-
-            if(mFirstFrame)
-            {
-                mStartTs = getWallTimestamp();
-                //std::cout << "VideoCapture: " << mStartTs << std::endl;
+            std::string msg = std::string("Grabbing wait failed: ") + std::string(strerror(errno));
+            ERROR_OUT(mParams.verbose,msg);
+            break;
+        }
 
-#ifdef SENSORS_MOD_AVAILABLE
-                if(mSyncEnabled && mSensPtr)
-                {
-                    // Synchronize reference timestamp
-                    mSensPtr->setStartTimestamp(mStartTs);
-                }
-#endif
+        bool deviceError = false;
+        bool frameReady = false;
 
-                mFirstFrame = false;
-                mInitTs = ts_uvc;
+        for( int i=0; i<n; i++ )
+        {
+            if( events[i].data.fd == mEventFd )
+            {
+                // Control event: stop request or configuration change
+                uint64_t count;
+                ssize_t res = read(mEventFd, &count, sizeof(count));
+                (void)res;
             }
-
-            rel_ts = ts_uvc - mInitTs;
-            // cvt to ns
-            rel_ts *= 1000;
-
-            mBufMutex.lock();
-            if (mLastFrame.data != nullptr && mWidth != 0 && mHeight != 0 && mBuffers[mCurrentIndex].start != nullptr)
+            else if( events[i].events & (EPOLLERR|EPOLLHUP) )
             {
-                mLastFrame.frame_id++;
-                memcpy(mLastFrame.data, (unsigned char*) mBuffers[mCurrentIndex].start, mBuffers[mCurrentIndex].length);
-                mLastFrame.timestamp = mStartTs + rel_ts;
-
-                //std::cout << "Video:\t" << mLastFrame.timestamp << std::endl;
-
-#ifdef SENSORS_MOD_AVAILABLE
-                if(mSensReadyToSync)
-                {
-                    mSensReadyToSync = false;
-                    mSensPtr->updateTimestampOffset(mLastFrame.timestamp);
-                }
-#endif
-
-                mNewFrame=true;
+                deviceError = true;
             }
-            mBufMutex.unlock();
-
-            mComMutex.lock();
-            ioctl(mFileDesc, VIDIOC_QBUF, &buf);
-            mComMutex.unlock();
+            else if( events[i].events & EPOLLIN )
+            {
+                frameReady = true;
+            }
+        }
 
-            capture_frame_count++;
+        if( deviceError && !mStopCapture )
+        {
+            std::string msg = std::string("Streaming error on '") + mDevName + "'. Grabbing stopped";
+            ERROR_OUT(mParams.verbose,msg);
+            break;
         }
-        else
+
+        if( frameReady )
         {
-            if (buf.bytesused != buf.length)
-            {
-                mComMutex.lock();
-                ioctl(mFileDesc, VIDIOC_QBUF, &buf);
-                mComMutex.unlock();
-            }
-            usleep(200);
-            buf.bytesused = -1;
-            buf.length = 0;
+            grabFrames( wake_ts );
         }
     }
 
+    close(epollFd);
+
     mGrabRunning = false;
 }
 
-const Frame& VideoCapture::getLastFrame( uint64_t timeout_msec )
+void VideoCapture::wakeGrabThread()
 {
-    // ----> Wait for a new frame
-    uint64_t time_count = timeout_msec*10;
-    while( !mNewFrame )
-    {
-        if(time_count==0)
-        {
-            return mLastFrame;
-        }
-        time_count--;
-        usleep(100);
-    }
-    // <---- Wait for a new frame
+    if( mEventFd == -1 )
+        return;
 
-    // Get the frame mutex
-    const std::lock_guard<std::mutex> lock(mBufMutex);
-    mNewFrame = false;
-    return mLastFrame;
+    uint64_t one = 1;
+    ssize_t res = write(mEventFd, &one, sizeof(one));
+    (void)res;
 }
 
-int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool safe)
+void VideoCapture::grabFrames( uint64_t wake_ts, std::vector<std::pair<uint64_t,uint64_t>>* clock_samples )
+{
+    struct v4l2_buffer buf;
+    bool firstBuf = true;
+    int freshest = -1;
+    uint64_t freshest_ts = 0;
+    uint64_t freshest_arrival = 0;
+
+    // ----> Dequeue all the available buffers
+    while( !mStopCapture )
+    {
+        memset(&(buf), 0, sizeof (buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = (mBufMemory==BUFFER_MEMORY::USERPTR)?V4L2_MEMORY_USERPTR:V4L2_MEMORY_MMAP;
+
+        // The streaming ioctls are serialized by the driver, they must not wait for the control transfers
+        int ret = ioctl(mFileDesc, VIDIOC_DQBUF, &buf);
+
+        if( ret != 0 )
+            break;
+
+        uint64_t dequeue_ts = getSteadyTimestamp();
+        uint64_t arrival_ts = getWallTimestamp();
+
+        mBufMutex.lock();
+        updateGrabStatsLocked(buf.sequence, dequeue_ts);
+        if( firstBuf )
+        {
+            updateLatencyStatsLocked(dequeue_ts-wake_ts);
+            firstBuf = false;
+        }
+        mBufMutex.unlock();
+
+        if( buf.index >= mBufCount )
+            continue;
+
+        // With USERPTR memory `buf.length` is the size of the user buffer, larger than the frame
+        if( buf.bytesused != mFrameSize || (buf.flags & V4L2_BUF_FLAG_ERROR) )
+        {
+            // Incomplete frame, the buffer can be used again
+            queueBuffer(buf.index);
+            continue;
+        }
+
+        // get buffer timestamp in us
+        uint64_t ts_uvc = ((uint64_t) buf.timestamp.tv_sec) * (1000 * 1000) + ((uint64_t) buf.timestamp.tv_usec);
+
+        if( mParams.ring_policy == RING_POLICY::LATEST )
+        {
+            // The frames dropped because not the freshest are still valid clock samples
+            if( clock_samples && freshest >= 0 && !mFirstFrame )
+                clock_samples->push_back( std::make_pair( mStartTs + (freshest_ts - mInitTs)*1000, freshest_arrival ) );
+
+            // Keep only the freshest frame
+            if( freshest >= 0 )
+            {
+                mBufMutex.lock();
+                mStats.stale_drops++;
+                mBufMutex.unlock();
+
+                queueBuffer(freshest);
+            }
+
+            freshest = buf.index;
+            freshest_ts = ts_uvc;
+            freshest_arrival = arrival_ts;
+            continue;
+        }
+
+        uint64_t frame_ts = publishBuffer(buf.index, ts_uvc, arrival_ts);
+        if( clock_samples )
+            clock_samples->push_back( std::make_pair( frame_ts, arrival_ts ) );
+    }
+    // <---- Dequeue all the available buffers
+
+    if( freshest >= 0 )
+    {
+        uint64_t frame_ts = publishBuffer(freshest, freshest_ts, freshest_arrival);
+        if( clock_samples )
+            clock_samples->push_back( std::make_pair( frame_ts, freshest_arrival ) );
+    }
+}
+
+uint64_t VideoCapture::publishBuffer( int index, uint64_t ts_uvc, uint64_t arrival_ts )
+{
+    if(mFirstFrame)
+    {
+        mStartTs = getWallTimestamp();
+        //std::cout << "VideoCapture: " << mStartTs << std::endl;
+
+#ifdef SENSORS_MOD_AVAILABLE
+        if(mSyncEnabled && mSensPtr)
+        {
+            // Synchronize reference timestamp
+            mSensPtr->setStartTimestamp(mStartTs);
+        }
+#endif
+
+        mFirstFrame = false;
+        mInitTs = ts_uvc;
+    }
+
+    uint64_t rel_ts = ts_uvc - mInitTs;
+    // cvt to ns
+    rel_ts *= 1000;
+
+    mBufMutex.lock();
+    Frame& bufFrame = mBufFrames[index];
+    bufFrame.frame_id = ++mFrameIdCount;
+    bufFrame.timestamp = mStartTs + rel_ts;
+    bufFrame.arrival_ts = arrival_ts;
+
+    //std::cout << "Video:\t" << bufFrame.timestamp << std::endl;
+
+#ifdef SENSORS_MOD_AVAILABLE
+    if(mSensReadyToSync)
+    {
+        mSensReadyToSync = false;
+        mSensPtr->updateTimestampOffset(bufFrame.timestamp);
+    }
+#endif
+
+    mBufMutex.unlock();
+
+    // ----> Subscribers receiving the frame
+    std::vector<std::shared_ptr<Subscriber>> receivers;
+    mSubMutex.lock();
+    for( auto& item : mSubscribers )
+    {
+        Subscriber* sub = item.second.get();
+        if( (sub->frameCount++ % sub->options.decimation) == 0 )
+            receivers.push_back(item.second);
+    }
+    mSubMutex.unlock();
+    // <---- Subscribers receiving the frame
+
+    bool history = !mHistorySlots.empty();
+
+    mBufMutex.lock();
+    // The frame ring, each receiving subscriber and the frame history own a reference
+    mBufRefCount[index] = 1 + static_cast<int>(receivers.size()) + (history?1:0);
+    Frame frame = mBufFrames[index];
+    pushRingLocked(index);
+    mBufMutex.unlock();
+
+    mFrameCond.notify_all();
+
+    // ----> Deliver the frame to the subscribers
+    for( auto& sub : receivers )
+    {
+        FrameLease dropped;
+
+        std::unique_lock<std::mutex> lock(sub->mutex);
+        if( sub->queue.size() >= sub->options.queue_depth )
+        {
+            dropped = std::move(sub->queue.front());
+            sub->queue.pop_front();
+            sub->stats.dropped++;
+        }
+        sub->queue.push_back(FrameLease(this, index, frame));
+        lock.unlock();
+
+        sub->cond.notify_one();
+    }
+    // <---- Deliver the frame to the subscribers
+
+    // The copy is done after delivering the frame to not delay the other consumers
+    if( history )
+    {
+        storeHistory(index);
+    }
+
+    return frame.timestamp;
+}
+
+// ----> Subscribers
+int VideoCapture::subscribe( FrameCallback callback, SubscriberOptions options )
+{
+    if( !callback )
+        return -1;
+
+    if( options.decimation == 0 )
+        options.decimation = 1;
+    if( options.queue_depth == 0 )
+        options.queue_depth = 1;
+
+    std::shared_ptr<Subscriber> sub = std::make_shared<Subscriber>();
+    sub->callback = callback;
+    sub->options = options;
+    sub->thread = std::thread( &VideoCapture::subscriberThreadFunc, this, sub );
+
+    const std::lock_guard<std::mutex> lock(mSubMutex);
+    int id = mNextSubId++;
+    mSubscribers[id] = sub;
+
+    return id;
+}
+
+bool VideoCapture::unsubscribe( int id )
+{
+    std::shared_ptr<Subscriber> sub;
+
+    mSubMutex.lock();
+    std::map<int,std::shared_ptr<Subscriber>>::iterator it = mSubscribers.find(id);
+    if( it != mSubscribers.end() )
+    {
+        sub = it->second;
+        mSubscribers.erase(it);
+    }
+    mSubMutex.unlock();
+
+    if( !sub )
+        return false;
+
+    std::deque<FrameLease> dropped;
+    {
+        const std::lock_guard<std::mutex> lock(sub->mutex);
+        sub->stop = true;
+        dropped.swap(sub->queue);
+    }
+    sub->cond.notify_all();
+
+    // A subscriber can be removed by its own callback
+    if( sub->thread.get_id() == std::this_thread::get_id() )
+        sub->thread.detach();
+    else if( sub->thread.joinable() )
+        sub->thread.join();
+
+    return true;
+}
+
+bool VideoCapture::getSubscriberStats( int id, SubscriberStats& stats )
+{
+    std::shared_ptr<Subscriber> sub;
+
+    mSubMutex.lock();
+    std::map<int,std::shared_ptr<Subscriber>>::iterator it = mSubscribers.find(id);
+    if( it != mSubscribers.end() )
+        sub = it->second;
+    mSubMutex.unlock();
+
+    if( !sub )
+        return false;
+
+    const std::lock_guard<std::mutex> lock(sub->mutex);
+    stats = sub->stats;
+    return true;
+}
+
+void VideoCapture::subscriberThreadFunc( std::shared_ptr<Subscriber> sub )
+{
+    std::unique_lock<std::mutex> lock(sub->mutex);
+
+    while( !sub->stop )
+    {
+        sub->cond.wait( lock, [&sub]{ return sub->stop || !sub->queue.empty(); } );
+
+        if( sub->stop )
+            break;
+
+        FrameLease lease = std::move(sub->queue.front());
+        sub->queue.pop_front();
+        sub->busy = true;
+        sub->stats.delivered++;
+        lock.unlock();
+
+        sub->callback(std::move(lease));
+
+        lock.lock();
+        sub->busy = false;
+        sub->cond.notify_all();
+    }
+}
+
+void VideoCapture::flushSubscribers()
+{
+    std::vector<std::shared_ptr<Subscriber>> subs;
+    mSubMutex.lock();
+    for( auto& item : mSubscribers )
+        subs.push_back(item.second);
+    mSubMutex.unlock();
+
+    for( auto& sub : subs )
+    {
+        std::deque<FrameLease> dropped;
+
+        std::unique_lock<std::mutex> lock(sub->mutex);
+        dropped.swap(sub->queue);
+        if( sub->thread.get_id() != std::this_thread::get_id() )
+            sub->cond.wait( lock, [&sub]{ return !sub->busy; } );
+        lock.unlock();
+    }
+}
+// <---- Subscribers
+
+// ----> Frame pyramid
+/*!
+ * \brief Builds the pyramid of an eye while the frame is copied, row pair by row pair
+ *
+ * Each level keeps its last two YUYV rows: when the second one is available they are downsampled
+ * to the next level, so that every row is processed while it is still in cache.
+ */
+class PyramidBuilder
+{
+public:
+    PyramidBuilder( const std::vector<ImageView>& levels, COLOR_FORMAT format )
+        : mLevels(levels)
+        , mFormat(format)
+        , mRowBuf(levels.size())
+        , mRowCount(levels.size(),0)
+    {
+        for( size_t l=0; l<levels.size(); l++ )
+        {
+            mRowBuf[l].resize( 4*static_cast<size_t>(levels[l].width) );
+        }
+    }
+
+    /*!
+     * \brief Add two consecutive YUYV rows of the eye
+     * \param row0 the first row, the second one follows at `step` bytes
+     * \param step the size in bytes of a frame row
+     * \param width the eye width in pixels
+     */
+    void addRows( const uint8_t* row0, size_t step, int width )
+    {
+        if( mLevels.empty() )
+            return;
+
+        downsampleYUYV( row0, step, nextRow(0), 2*mLevels[0].width, width, 2, 1 );
+        pushRow(0);
+    }
+
+private:
+    // The YUYV row buffer receiving the next row of a level
+    uint8_t* nextRow( size_t level )
+    {
+        return mRowBuf[level].data() + (mRowCount[level]%2)*2*mLevels[level].width;
+    }
+
+    // Convert the new row of a level to the output format, then downsample the last two rows to the next level
+    void pushRow( size_t level )
+    {
+        const ImageView& view = mLevels[level];
+        if( mRowCount[level]>=view.height )
+            return;
+
+        const uint8_t* yuyv = nextRow(level);
+        uint8_t* dst = const_cast<uint8_t*>( view.row(mRowCount[level]) );
+        convertYUYV( yuyv, 2*view.width, dst, view.step, view.width, 1, mFormat, 1 );
+
+        bool pairDone = (mRowCount[level]%2)==1;
+        mRowCount[level]++;
+
+        if( pairDone && level+1<mLevels.size() )
+        {
+            downsampleYUYV( mRowBuf[level].data(), 2*view.width, nextRow(level+1), 2*mLevels[level+1].width,
+                            view.width, 2, 1 );
+            pushRow(level+1);
+        }
+    }
+
+    const std::vector<ImageView>& mLevels;      //!< Levels of the eye
+    COLOR_FORMAT mFormat;                       //!< Output format of the levels
+    std::vector<std::vector<uint8_t>> mRowBuf;  //!< Last two YUYV rows of each level
+    std::vector<int> mRowCount;                 //!< Number of rows of each level already produced
+};
+
+int VideoCapture::getPyramidLevels()
+{
+    int levels = std::min<int>( mParams.pyramid_levels, PYRAMID_MAX_LEVELS );
+
+    // Each level must have at least one row and one YUYV pixel pair
+    int width = mWidth/2;
+    int height = mHeight;
+    for( int l=0; l<levels; l++ )
+    {
+        width = (width/2)&~1;
+        height /= 2;
+        if( width<2 || height<1 )
+            return l;
+    }
+
+    return levels;
+}
+
+size_t VideoCapture::getPyramidSize()
+{
+    size_t channels = (mParams.pyramid_format==PYRAMID_FORMAT::BGR)?3:1;
+    size_t size = 0;
+
+    int width = mWidth/2;
+    int height = mHeight;
+    for( int l=0; l<getPyramidLevels(); l++ )
+    {
+        width = (width/2)&~1;
+        height /= 2;
+
+        size_t step = (width*channels + PYRAMID_ALIGN-1) & ~static_cast<size_t>(PYRAMID_ALIGN-1);
+        size += step*height;
+    }
+
+    return 2*size; // Two eyes
+}
+
+void VideoCapture::allocatePyramid( FramePyramid& pyramid )
+{
+    pyramid.left.clear();
+    pyramid.right.clear();
+    pyramid.memory.reset();
+
+    int levels = getPyramidLevels();
+    if( levels==0 )
+        return;
+
+    void* memory = nullptr;
+    if( posix_memalign( &memory, PYRAMID_ALIGN, getPyramidSize() )!=0 )
+    {
+        ERROR_OUT(mParams.verbose,"Cannot allocate the frame pyramid");
+        return;
+    }
+    pyramid.memory.reset( static_cast<uint8_t*>(memory), free );
+
+    int channels = (mParams.pyramid_format==PYRAMID_FORMAT::BGR)?3:1;
+    uint8_t* ptr = pyramid.memory.get();
+
+    for( int eye=0; eye<2; eye++ )
+    {
+        std::vector<ImageView>& views = (eye==0)?pyramid.left:pyramid.right;
+
+        int width = mWidth/2;
+        int height = mHeight;
+        for( int l=0; l<levels; l++ )
+        {
+            width = (width/2)&~1;
+            height /= 2;
+
+            ImageView view;
+            view.data = ptr;
+            view.width = width;
+            view.height = height;
+            view.channels = channels;
+            view.step = (width*channels + PYRAMID_ALIGN-1) & ~static_cast<size_t>(PYRAMID_ALIGN-1);
+            views.push_back(view);
+
+            ptr += view.step*height;
+        }
+    }
+}
+// <---- Frame pyramid
+
+// ----> Frame history
+void VideoCapture::createHistory()
+{
+    size_t frameSize = getOutputFrameSize() + getPyramidSize();
+    size_t depth = mParams.history_depth;
+
+    if( depth>0 && mParams.history_max_bytes>0 )
+    {
+        depth = std::min<size_t>( depth, mParams.history_max_bytes/frameSize );
+
+        if( depth==0 )
+        {
+            WARNING_OUT(mParams.verbose,"The frame history memory budget is smaller than a frame, history disabled");
+        }
+    }
+
+    const std::lock_guard<std::mutex> lock(mHistMutex);
+
+    mHistorySlots.clear();
+    mHistory.clear();
+    mHistoryFree.clear();
+
+    mHistorySlots.resize(depth);
+    for( size_t i = 0; i < depth; ++i )
+    {
+        mHistorySlots[i].data.reset( new uint8_t[getOutputFrameSize()] );
+        allocatePyramid( mHistorySlots[i].pyramid );
+        mHistoryFree.push_back( static_cast<int>(depth-1-i) );
+    }
+}
+
+void VideoCapture::storeHistory( int index )
+{
+    int slot = -1;
+
+    // ----> Get a free slot or the oldest frame not leased
+    mHistMutex.lock();
+    if( !mHistoryFree.empty() )
+    {
+        slot = mHistoryFree.back();
+        mHistoryFree.pop_back();
+    }
+    else
+    {
+        for( std::deque<int>::iterator it = mHistory.begin(); it != mHistory.end(); ++it )
+        {
+            if( mHistorySlots[*it].refCount == 0 )
+            {
+                slot = *it;
+                mHistory.erase(it);
+                break;
+            }
+        }
+    }
+    mHistMutex.unlock();
+    // <---- Get a free slot or the oldest frame not leased
+
+    if( slot<0 )
+    {
+        mBufMutex.lock();
+        mStats.history_drops++;
+        mBufMutex.unlock();
+
+        releaseBuffer(index);
+        return;
+    }
+
+    // The slot is not reachable by the lookup functions, so it can be written without locks
+    HistorySlot& histSlot = mHistorySlots[slot];
+    const Frame& bufFrame = mBufFrames[index];
+
+    copyFrameData( bufFrame, mBuffers[index].length, histSlot.data.get(), &histSlot.pyramid );
+    histSlot.frame = bufFrame;
+    histSlot.frame.data = histSlot.data.get();
+    histSlot.frame.channels = mLastFrame.channels;
+    histSlot.frame.pyramid = histSlot.pyramid.memory?&histSlot.pyramid:nullptr;
+    histSlot.frame.dmabuf_fd = -1;
+    histSlot.frame.dmabuf_size = 0;
+
+    releaseBuffer(index);
+
+    const std::lock_guard<std::mutex> lock(mHistMutex);
+    mHistory.push_back(slot);
+}
+
+size_t VideoCapture::getOutputFrameSize()
+{
+    size_t channels = (mParams.output_format==OUTPUT_FORMAT::GRAY)?1:mChannels;
+    return static_cast<size_t>(mWidth) * mHeight * channels;
+}
+
+void VideoCapture::copyFrameData( const Frame& src, size_t src_length, uint8_t* dst, FramePyramid* pyramid )
+{
+    size_t rowSize = static_cast<size_t>(src.width) * src.channels;
+    int rows = static_cast<int>( std::min<size_t>( src.height, src_length/rowSize ) );
+    bool gray = (mParams.output_format==OUTPUT_FORMAT::GRAY);
+
+    if( !pyramid || !pyramid->memory )
+    {
+        if( gray )
+        {
+            // Luma extraction only: half of the memory written and no color conversion
+            convertYUYV( src.data, rowSize, dst, src.width, src.width, rows, COLOR_FORMAT::GRAY, 1 );
+            return;
+        }
+
+        memcpy( dst, src.data, rowSize*rows );
+        return;
+    }
+
+    // ----> Copy and pyramid construction, two rows at a time while they are in cache
+    COLOR_FORMAT format = (mParams.pyramid_format==PYRAMID_FORMAT::BGR)?COLOR_FORMAT::BGR:COLOR_FORMAT::GRAY;
+    PyramidBuilder left( pyramid->left, format );
+    PyramidBuilder right( pyramid->right, format );
+
+    int eyeWidth = src.width/2;
+    size_t dstRowSize = gray?src.width:rowSize;
+
+    for( int row=0; row<rows; row+=2 )
+    {
+        int count = std::min( 2, rows-row );
+        const uint8_t* srcRow = src.data + row*rowSize;
+        uint8_t* dstRow = dst + row*dstRowSize;
+
+        if( gray )
+            convertYUYV( srcRow, rowSize, dstRow, src.width, src.width, count, COLOR_FORMAT::GRAY, 1 );
+        else
+            memcpy( dstRow, srcRow, rowSize*count );
+
+        if( count==2 )
+        {
+            left.addRows( srcRow, rowSize, eyeWidth );
+            right.addRows( srcRow + 2*eyeWidth, rowSize, eyeWidth );
+        }
+    }
+    // <---- Copy and pyramid construction, two rows at a time while they are in cache
+}
+
+void VideoCapture::releaseHistorySlot( int slot )
+{
+    const std::lock_guard<std::mutex> lock(mHistMutex);
+
+    if( slot >= 0 && slot < static_cast<int>(mHistorySlots.size()) && mHistorySlots[slot].refCount > 0 )
+    {
+        mHistorySlots[slot].refCount--;
+    }
+}
+
+FrameLease VideoCapture::leaseHistoryLocked( size_t pos )
+{
+    int slot = mHistory[pos];
+    mHistorySlots[slot].refCount++;
+
+    return FrameLease(this, slot, mHistorySlots[slot].frame, true);
+}
+
+FrameLease VideoCapture::findFrameByTimestamp( uint64_t timestamp, uint64_t max_distance )
+{
+    const std::lock_guard<std::mutex> lock(mHistMutex);
+
+    if( mHistory.empty() )
+        return FrameLease();
+
+    // First frame not older than `timestamp`
+    std::deque<int>::iterator it = std::lower_bound( mHistory.begin(), mHistory.end(), timestamp,
+                                                     [this](int slot, uint64_t ts) {
+        return mHistorySlots[slot].frame.timestamp < ts;
+    });
+
+    size_t pos = static_cast<size_t>(it - mHistory.begin());
+    if( pos == mHistory.size() )
+    {
+        pos--;
+    }
+    else if( pos > 0 )
+    {
+        uint64_t after = mHistorySlots[mHistory[pos]].frame.timestamp - timestamp;
+        uint64_t before = timestamp - mHistorySlots[mHistory[pos-1]].frame.timestamp;
+        if( before < after )
+            pos--;
+    }
+
+    uint64_t frameTs = mHistorySlots[mHistory[pos]].frame.timestamp;
+    uint64_t distance = (frameTs>timestamp)?(frameTs-timestamp):(timestamp-frameTs);
+    if( max_distance>0 && distance>max_distance )
+        return FrameLease();
+
+    return leaseHistoryLocked(pos);
+}
+
+FrameLease VideoCapture::findFrameById( uint64_t frame_id )
+{
+    const std::lock_guard<std::mutex> lock(mHistMutex);
+
+    std::deque<int>::iterator it = std::lower_bound( mHistory.begin(), mHistory.end(), frame_id,
+                                                     [this](int slot, uint64_t id) {
+        return mHistorySlots[slot].frame.frame_id < id;
+    });
+
+    if( it == mHistory.end() || mHistorySlots[*it].frame.frame_id != frame_id )
+        return FrameLease();
+
+    return leaseHistoryLocked( static_cast<size_t>(it - mHistory.begin()) );
+}
+// <---- Frame history
+
+void VideoCapture::updateLatencyStatsLocked( uint64_t latency )
+{
+    mStats.wakeups++;
+    mStats.dequeue_latency_last = latency;
+    if( latency > mStats.dequeue_latency_max )
+        mStats.dequeue_latency_max = latency;
+    mStats.dequeue_latency_avg += (static_cast<double>(latency)-mStats.dequeue_latency_avg)/mStats.wakeups;
+}
+
+void VideoCapture::updateGrabStatsLocked( uint32_t sequence, uint64_t dequeue_ts )
+{
+    if( mStats.grabbed_frames>0 && sequence>mLastSequence+1 )
+    {
+        mStats.driver_drops += sequence-mLastSequence-1;
+    }
+
+    // ----> Dequeue jitter
+    if( mStats.grabbed_frames>0 && mFps>0 )
+    {
+        uint64_t interval = dequeue_ts-mLastDequeueTs;
+        // Frames lost by the driver are not jitter
+        uint64_t expected = (1000000000ULL/mFps) * (sequence>mLastSequence?(sequence-mLastSequence):1);
+        uint64_t jitter = (interval>expected)?(interval-expected):(expected-interval);
+
+        mStats.dequeue_interval_last = interval;
+        if( jitter > mStats.dequeue_jitter_max )
+            mStats.dequeue_jitter_max = jitter;
+        mStats.dequeue_jitter_avg += (static_cast<double>(jitter)-mStats.dequeue_jitter_avg)/mStats.grabbed_frames;
+    }
+    mLastDequeueTs = dequeue_ts;
+    // <---- Dequeue jitter
+
+    mLastSequence = sequence;
+    mStats.grabbed_frames++;
+}
+
+void VideoCapture::pushRingLocked( int index )
+{
+    if( mRing.empty() )
+    {
+        releaseBufferLocked(index);
+        return;
+    }
+
+    // Ring full: the oldest frame is lost
+    if( mRingCount == mRing.size() )
+    {
+        releaseBufferLocked(popRingLocked());
+        mStats.ring_overruns++;
+    }
+
+    mRing[(mRingHead+mRingCount)%mRing.size()] = index;
+    mRingCount++;
+}
+
+int VideoCapture::popRingLocked()
+{
+    if( mRingCount==0 )
+        return -1;
+
+    int index = mRing[mRingHead];
+    mRingHead = (mRingHead+1)%mRing.size();
+    mRingCount--;
+
+    return index;
+}
+
+bool VideoCapture::ringHasFrameAfterLocked( uint64_t frame_id )
+{
+    if( mRingCount==0 )
+        return false;
+
+    // Frames are stored in order, check the newest
+    int newest = mRing[(mRingHead+mRingCount-1)%mRing.size()];
+    return mBufFrames[newest].frame_id > frame_id;
+}
+
+int VideoCapture::takeBuffer( std::chrono::steady_clock::time_point deadline, uint64_t after_frame_id, bool oldest )
+{
+    std::unique_lock<std::mutex> lock(mBufMutex);
+
+    // ----> Wait for a new frame
+    bool available = mFrameCond.wait_until( lock, deadline, [this,after_frame_id]
+    {
+        return mStopCapture || ringHasFrameAfterLocked(after_frame_id);
+    });
+
+    if( !available || !ringHasFrameAfterLocked(after_frame_id) )
+    {
+        return -1;
+    }
+    // <---- Wait for a new frame
+
+    // Frames already processed are discarded
+    int index = popRingLocked();
+    while( mBufFrames[index].frame_id <= after_frame_id )
+    {
+        releaseBufferLocked(index);
+        index = popRingLocked();
+    }
+
+    // Older frames are discarded when the freshest frame is requested
+    while( !oldest && mRingCount>0 )
+    {
+        releaseBufferLocked(index);
+        index = popRingLocked();
+    }
+
+    // The reference owned by the frame ring is moved to the caller
+    return index;
+}
+
+void VideoCapture::releaseBuffer( int index )
+{
+    const std::lock_guard<std::mutex> lock(mBufMutex);
+    releaseBufferLocked(index);
+}
+
+void VideoCapture::releaseBufferLocked( int index )
+{
+    if( index<0 || index>=static_cast<int>(mBufRefCount.size()) || mBufRefCount[index]==0 )
+        return;
+
+    if( --mBufRefCount[index] > 0 )
+        return;
+
+    queueBuffer(index);
+}
+
+bool VideoCapture::queueBuffer( int index )
+{
+    if( mFileDesc==-1 || mStopCapture )
+        return false;
+
+    struct v4l2_buffer buf;
+    initV4l2Buffer(buf, index);
+
+    return (0 == ioctl(mFileDesc, VIDIOC_QBUF, &buf));
+}
+
+CaptureStats VideoCapture::getCaptureStats()
+{
+    const std::lock_guard<std::mutex> lock(mBufMutex);
+    return mStats;
+}
+
+const Frame& VideoCapture::getLastFrame( uint64_t timeout_msec, bool* timed_out )
+{
+    int index = takeBuffer( std::chrono::steady_clock::now()+std::chrono::milliseconds(timeout_msec), 0, false );
+
+    if( timed_out )
+    {
+        *timed_out = (index<0);
+    }
+
+    if( index<0 )
+    {
+        return mLastFrame;
+    }
+
+    // The buffer cannot be queued again until released, so the copy does not require the frame mutex
+    const Frame& bufFrame = mBufFrames[index];
+    if (mLastFrame.data != nullptr && bufFrame.data != nullptr)
+    {
+        copyFrameData(bufFrame, mBuffers[index].length, mLastFrame.data, &mLastPyramid);
+        mLastFrame.frame_id = bufFrame.frame_id;
+        mLastFrame.timestamp = bufFrame.timestamp;
+        mLastFrame.arrival_ts = bufFrame.arrival_ts;
+    }
+
+    releaseBuffer(index);
+
+    return mLastFrame;
+}
+
+FrameLease VideoCapture::leaseLastFrame( uint64_t timeout_msec )
+{
+    int index = takeBuffer( std::chrono::steady_clock::now()+std::chrono::milliseconds(timeout_msec), 0, false );
+    if( index<0 )
+    {
+        return FrameLease();
+    }
+
+    return FrameLease(this, index, mBufFrames[index]);
+}
+
+FrameLease VideoCapture::leaseNextFrame( uint64_t timeout_msec )
+{
+    int index = takeBuffer( std::chrono::steady_clock::now()+std::chrono::milliseconds(timeout_msec), 0, true );
+    if( index<0 )
+    {
+        return FrameLease();
+    }
+
+    return FrameLease(this, index, mBufFrames[index]);
+}
+
+FrameLease VideoCapture::waitForFrame( uint64_t after_frame_id, uint64_t deadline )
+{
+    std::chrono::steady_clock::time_point deadline_tp(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(deadline)));
+
+    int index = takeBuffer( deadline_tp, after_frame_id, true );
+    if( index<0 )
+    {
+        return FrameLease();
+    }
+
+    return FrameLease(this, index, mBufFrames[index]);
+}
+
+// ----> FrameLease
+FrameLease::FrameLease(VideoCapture* cap, int index, const Frame& frame, bool history)
+    : mCap(cap)
+    , mIndex(index)
+    , mHistory(history)
+    , mFrame(frame)
+{
+}
+
+FrameLease::~FrameLease()
+{
+    release();
+}
+
+FrameLease::FrameLease(FrameLease&& other)
+    : mCap(other.mCap)
+    , mIndex(other.mIndex)
+    , mHistory(other.mHistory)
+    , mFrame(other.mFrame)
+{
+    other.mCap = nullptr;
+    other.mIndex = -1;
+}
+
+FrameLease& FrameLease::operator=(FrameLease&& other)
+{
+    if( this != &other )
+    {
+        release();
+
+        mCap = other.mCap;
+        mIndex = other.mIndex;
+        mHistory = other.mHistory;
+        mFrame = other.mFrame;
+
+        other.mCap = nullptr;
+        other.mIndex = -1;
+    }
+
+    return *this;
+}
+
+void FrameLease::release()
+{
+    if( mCap )
+    {
+        if( mHistory )
+            mCap->releaseHistorySlot(mIndex);
+        else
+            mCap->releaseBuffer(mIndex);
+    }
+
+    mCap = nullptr;
+    mIndex = -1;
+    mHistory = false;
+    mFrame = Frame();
+}
+// <---- FrameLease
+
+int VideoCapture::ll_VendorControl(uint8_t *buf, int len, int readMode, bool safe)
 {
     if (len > 384)
         return -2;
@@ -1216,6 +2552,311 @@ int VideoCapture::ll_write_sensor_register(int side, int sscb_id, uint64_t addre
     return hr;
 }
 
+// Registers per multi-register transfer, the data must fit the 64 bytes of the USB2 control transfers
+#define XU_BURST_MAX    32
+
+int VideoCapture::ll_read_system_registers(uint64_t address, uint8_t* values, int count)
+{
+    int hr = 0;
+
+    if (count == 1 || !mSystemBurst)
+    {
+        for (int i = 0; i < count; i++)
+            hr += ll_read_system_register(address + i, values + i);
+        return hr;
+    }
+
+    for (int done = 0; done < count; done += XU_BURST_MAX)
+    {
+        int len = std::min(count - done, XU_BURST_MAX);
+        uint64_t addr = address + done;
+
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
+
+        xu_buf[0] = XU_TASK_GET;
+        xu_buf[1] = 0xA2;
+        xu_buf[2] = 0;
+        xu_buf[3] = 0x04; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((addr) >> 24) & 0xff;
+        xu_buf[6] = ((addr) >> 16) & 0xff;
+        xu_buf[7] = ((addr) >> 8) & 0xff;
+        xu_buf[8] = (addr) & 0xff;
+        xu_buf[9] = (len >> 8) & 0xff;
+        xu_buf[10] = len & 0xff;
+        xu_buf[11] = (len >> 8) & 0xff;
+        xu_buf[12] = len & 0xff;
+
+        hr = ll_VendorControl(xu_buf, 384, READ_MODE);
+        if (hr != 0)
+        {
+            // Multi-register transfers not supported, fall back to single register transfers
+            mSystemBurst = false;
+            return ll_read_system_registers(address, values, count);
+        }
+
+        memcpy(values + done, &xu_buf[17], len);
+    }
+
+    return hr;
+}
+
+int VideoCapture::ll_write_system_registers(uint64_t address, const uint8_t* values, int count)
+{
+    int hr = 0;
+
+    if (count == 1 || !mSystemBurst)
+    {
+        for (int i = 0; i < count; i++)
+            hr += ll_write_system_register(address + i, values[i]);
+        return hr;
+    }
+
+    for (int done = 0; done < count; done += XU_BURST_MAX)
+    {
+        int len = std::min(count - done, XU_BURST_MAX);
+        uint64_t addr = address + done;
+
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
+
+        xu_buf[0] = XU_TASK_SET;
+        xu_buf[1] = 0xA2;
+        xu_buf[2] = 0;
+        xu_buf[3] = 0x04; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((addr) >> 24) & 0xff;
+        xu_buf[6] = ((addr) >> 16) & 0xff;
+        xu_buf[7] = ((addr) >> 8) & 0xff;
+        xu_buf[8] = (addr) & 0xff;
+        xu_buf[9] = (len >> 8) & 0xff;
+        xu_buf[10] = len & 0xff;
+        xu_buf[11] = (len >> 8) & 0xff;
+        xu_buf[12] = len & 0xff;
+        memcpy(&xu_buf[16], values + done, len);
+
+        hr = ll_VendorControl(xu_buf, 384, 0);
+        if (hr != 0)
+        {
+            // Multi-register transfers not supported, fall back to single register transfers
+            mSystemBurst = false;
+            return ll_write_system_registers(address, values, count);
+        }
+    }
+
+    return hr;
+}
+
+int VideoCapture::ll_read_sensor_registers(int side, int sscb_id, uint64_t address, uint8_t* values, int count)
+{
+    int hr = 0;
+
+    if (count == 1 || !mSensorBurst)
+    {
+        for (int i = 0; i < count; i++)
+            hr += ll_read_sensor_register(side, sscb_id, address + i, values + i);
+        return hr;
+    }
+
+    for (int done = 0; done < count; done += XU_BURST_MAX)
+    {
+        int len = std::min(count - done, XU_BURST_MAX);
+        uint64_t addr = address + done;
+
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
+
+        xu_buf[0] = XU_TASK_GET;
+        if (side == 0)
+            xu_buf[1] = ASIC_INT_NULL_I2C;
+        else
+            xu_buf[1] = ASIC_INT_I2C;
+        xu_buf[2] = 0x6c;
+        xu_buf[3] = sscb_id + 1; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((addr) >> 24) & 0xff;
+        xu_buf[6] = ((addr) >> 16) & 0xff;
+        xu_buf[7] = ((addr) >> 8) & 0xff;
+        xu_buf[8] = (addr) & 0xff;
+
+        //set page addr and length
+        xu_buf[9] = 0x90 | ((len >> 8) & 0x0f);
+        xu_buf[10] = len & 0xff;
+        xu_buf[11] = (len >> 8) & 0xff;
+        xu_buf[12] = len & 0xff;
+
+        hr = ll_VendorControl(xu_buf, 384, READ_MODE);
+        if (hr != 0)
+        {
+            // Multi-register transfers not supported, fall back to single register transfers
+            mSensorBurst = false;
+            return ll_read_sensor_registers(side, sscb_id, address, values, count);
+        }
+
+        memcpy(values + done, &xu_buf[17], len);
+    }
+
+    return hr;
+}
+
+int VideoCapture::ll_write_sensor_registers(int side, int sscb_id, uint64_t address, const uint8_t* values, int count)
+{
+    int hr = 0;
+
+    if (count == 1 || !mSensorBurst)
+    {
+        for (int i = 0; i < count; i++)
+            hr += ll_write_sensor_register(side, sscb_id, address + i, values[i]);
+        return hr;
+    }
+
+    for (int done = 0; done < count; done += XU_BURST_MAX)
+    {
+        int len = std::min(count - done, XU_BURST_MAX);
+        uint64_t addr = address + done;
+
+        unsigned char xu_buf[384];
+        memset(xu_buf, 0, 384);
+
+        xu_buf[0] = XU_TASK_SET;
+        if (side == 0)
+            xu_buf[1] = ASIC_INT_NULL_I2C;
+        else
+            xu_buf[1] = ASIC_INT_I2C;
+        xu_buf[2] = 0x6c;
+        xu_buf[3] = sscb_id + 1; //Address width in bytes
+        xu_buf[4] = 0x01; //data width in bytes
+
+        xu_buf[5] = ((addr) >> 24) & 0xff;
+        xu_buf[6] = ((addr) >> 16) & 0xff;
+        xu_buf[7] = ((addr) >> 8) & 0xff;
+        xu_buf[8] = (addr) & 0xff;
+
+        //set page addr and length
+        xu_buf[9] = 0x90 | ((len >> 8) & 0x0f);
+        xu_buf[10] = len & 0xff;
+        xu_buf[11] = (len >> 8) & 0xff;
+        xu_buf[12] = len & 0xff;
+        memcpy(&xu_buf[16], values + done, len);
+
+        hr = ll_VendorControl(xu_buf, 384, 0);
+        if (hr != 0)
+        {
+            // Multi-register transfers not supported, fall back to single register transfers
+            mSensorBurst = false;
+            return ll_write_sensor_registers(side, sscb_id, address, values, count);
+        }
+    }
+
+    return hr;
+}
+
+int VideoCapture::ll_sensor_transaction(const std::vector<SensorRegBlock>& blocks, bool verify)
+{
+    const std::lock_guard<std::mutex> lock(mRegMutex);
+    return ll_sensor_transaction_locked(blocks, verify);
+}
+
+int VideoCapture::ll_sensor_transaction_locked(const std::vector<SensorRegBlock>& blocks, bool verify)
+{
+    int hr = 0;
+
+    // All the writes are sent before the verification to apply them as close in time as possible
+    for (const SensorRegBlock& block : blocks)
+        hr += ll_write_sensor_registers(block.side, 1, block.address, block.values.data(), static_cast<int>(block.values.size()));
+
+    if (hr != 0 || !verify)
+        return hr;
+
+    // ----> Bulk verification
+    bool match = true;
+    for (const SensorRegBlock& block : blocks)
+    {
+        std::vector<uint8_t> values(block.values.size());
+        hr += ll_read_sensor_registers(block.side, 1, block.address, values.data(), static_cast<int>(values.size()));
+        match = match && (values == block.values);
+    }
+    // <---- Bulk verification
+
+    if (hr != 0)
+        return hr;
+
+    if (!match)
+    {
+        if (mSensorBurst)
+        {
+            // The firmware ignored the multi-register transfers, retry with single register transfers
+            WARNING_OUT(mParams.verbose,"Multi-register sensor transfers not supported by the firmware");
+            mSensorBurst = false;
+            return ll_sensor_transaction_locked(blocks, verify);
+        }
+
+        return -3;
+    }
+
+    return 0;
+}
+
+// Registers from the Exposure to the Gain ones, changed only by the AEC/AGC
+#define BURST_PROBE_COUNT   (ADD_GAIN_H + 3 - ADD_EXP_H)
+#define BURST_PROBE_RETRIES 3
+
+bool VideoCapture::ll_probe_sensor_burst()
+{
+    // The firmware may ignore the register count of the burst reads and return a single valid register:
+    // the burst transfers are used only if a burst read returns the values of the single register reads
+    mSensorBurst = false;
+
+    bool nonZero = false;
+    for (int side = 0; side < 2; side++)
+    {
+        bool stable = false;
+        for (int retry = 0; retry < BURST_PROBE_RETRIES && !stable; retry++)
+        {
+            uint8_t before[BURST_PROBE_COUNT], burst[BURST_PROBE_COUNT], after[BURST_PROBE_COUNT];
+
+            if (ll_read_sensor_registers(side, 1, ADD_EXP_H, before, BURST_PROBE_COUNT) != 0)
+                return false;
+
+            mSensorBurst = true;
+            int hr = ll_read_sensor_registers(side, 1, ADD_EXP_H, burst, BURST_PROBE_COUNT);
+            bool supported = mSensorBurst;
+            mSensorBurst = false;
+            if (hr != 0 || !supported)
+                return false;
+
+            if (ll_read_sensor_registers(side, 1, ADD_EXP_H, after, BURST_PROBE_COUNT) != 0)
+                return false;
+
+            // The AEC/AGC may change the registers during the probe, retry
+            if (memcmp(before, after, BURST_PROBE_COUNT) != 0)
+                continue;
+
+            if (memcmp(before, burst, BURST_PROBE_COUNT) != 0)
+            {
+                WARNING_OUT(mParams.verbose,"Multi-register sensor transfers not supported by the firmware");
+                return false;
+            }
+
+            for (int i = 1; i < BURST_PROBE_COUNT; i++)
+                nonZero = nonZero || (before[i] != 0);
+
+            stable = true;
+        }
+
+        if (!stable)
+            return false;
+    }
+
+    // Only null registers after the first one: not enough to prove that the count is honoured
+    mSensorBurst = nonZero;
+    return mSensorBurst;
+}
+
 int VideoCapture::ll_SPI_FlashProgramRead(uint8_t *pBuf, int Adr, int len) {
 
     int hr = -1;
@@ -1293,56 +2934,48 @@ int VideoCapture::ll_isp_is_aecagc(int side) {
 }
 
 int VideoCapture::ll_isp_get_gain(uint8_t *val, uint8_t sensorID) {
-    int hr = 0;
-    uint8_t buffL, buffM, buffH;
+    uint8_t buff[3] = {0}; // H, M, L
 
-    hr += ll_read_sensor_register(sensorID, 1, ADD_GAIN_H, &buffH);
-    hr += ll_read_sensor_register(sensorID, 1, ADD_GAIN_M, &buffM);
-    hr += ll_read_sensor_register(sensorID, 1, ADD_GAIN_L, &buffL);
+    int hr = ll_read_sensor_registers(sensorID, 1, ADD_GAIN_H, buff, 3);
 
-    *val = buffL;
-    *(val + 1) = buffM;
-    *(val + 2) = buffH;
+    *val = buff[2];
+    *(val + 1) = buff[1];
+    *(val + 2) = buff[0];
 
     return hr;
 }
 
 int VideoCapture::ll_isp_set_gain(unsigned char ucGainH, unsigned char ucGainM, unsigned char ucGainL, int sensorID)
 {
-    int hr = 0;
-    hr += ll_write_sensor_register(sensorID, 1, ADD_GAIN_H, ucGainH);
-    hr += ll_write_sensor_register(sensorID, 1, ADD_GAIN_M, ucGainM);
-    hr += ll_write_sensor_register(sensorID, 1, ADD_GAIN_L, ucGainL);
-    return hr;
+    std::vector<SensorRegBlock> blocks(1);
+    blocks[0].side = sensorID;
+    blocks[0].address = ADD_GAIN_H;
+    blocks[0].values = {ucGainH, ucGainM, ucGainL};
+
+    return ll_sensor_transaction(blocks, true);
 }
 
 int VideoCapture::ll_isp_get_exposure(unsigned char *val, unsigned char sensorID)
 {
-    int hr = 0;
-    uint8_t buffL = 0;
-    uint8_t buffM = 0;
-    uint8_t buffH = 0;
+    uint8_t buff[3] = {0}; // H, M, L
 
-    hr += ll_read_sensor_register(sensorID, 1, ADD_EXP_H, (uint8_t*) & buffH);
-    usleep(10);
-    hr += ll_read_sensor_register(sensorID, 1, ADD_EXP_M, (uint8_t*) & buffM);
-    usleep(10);
-    hr += ll_read_sensor_register(sensorID, 1, ADD_EXP_L, (uint8_t*) & buffL);
+    int hr = ll_read_sensor_registers(sensorID, 1, ADD_EXP_H, buff, 3);
 
-    *val = buffL;
-    *(val + 1) = buffM;
-    *(val + 2) = buffH;
+    *val = buff[2];
+    *(val + 1) = buff[1];
+    *(val + 2) = buff[0];
 
     return hr;
 }
 
 int VideoCapture::ll_isp_set_exposure(unsigned char ucExpH, unsigned char ucExpM, unsigned char ucExpL, int sensorID)
 {
-    int hr = 0;
-    hr += ll_write_sensor_register(sensorID, 1, ADD_EXP_H, ucExpH);
-    hr += ll_write_sensor_register(sensorID, 1, ADD_EXP_M, ucExpM);
-    hr += ll_write_sensor_register(sensorID, 1, ADD_EXP_L, ucExpL);
-    return hr;
+    std::vector<SensorRegBlock> blocks(1);
+    blocks[0].side = sensorID;
+    blocks[0].address = ADD_EXP_H;
+    blocks[0].values = {ucExpH, ucExpM, ucExpL};
+
+    return ll_sensor_transaction(blocks, true);
 }
 
 void VideoCapture::ll_activate_sync()
@@ -1367,6 +3000,10 @@ int VideoCapture::setLEDstatus(bool status)
         hr += ll_set_gpio_value(2, 0);
     }
 
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.ledValid = (hr==0);
+    mCtrlCache.led = status;
+
     return hr;
 }
 
@@ -1377,10 +3014,24 @@ int VideoCapture::getLEDstatus(bool *status)
         return -1;
     }
 
+    mCacheMutex.lock();
+    if( mCtrlCache.ledValid )
+    {
+        *status = mCtrlCache.led;
+        mCacheMutex.unlock();
+        return 0;
+    }
+    mCacheMutex.unlock();
+
     uint8_t val;
     int hr = ll_set_gpio_direction(2, 1);
     hr += ll_get_gpio_value(2, &val);
     *status = val!=0;
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.ledValid = (hr==0);
+    mCtrlCache.led = *status;
+
     return hr;
 }
 
@@ -1425,32 +3076,48 @@ int VideoCapture::getCameraControlSettings(int ctrl_id)
     return res;
 }
 
-void VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
-    struct v4l2_control control_s;
+VideoCapture::ControlRange VideoCapture::getControlRange(int ctrl_id)
+{
+    const std::lock_guard<std::mutex> lock(mRangeMutex);
+
+    std::map<int,ControlRange>::iterator it = mCtrlRanges.find(ctrl_id);
+    if (it != mCtrlRanges.end())
+        return it->second;
+
     struct v4l2_queryctrl queryctrl;
     memset(&queryctrl, 0, sizeof (queryctrl));
-    memset(&control_s, 0, sizeof (control_s));
-    int min, max/*, step, val_def*/;
-
-    // save_controls(fd);
     queryctrl.id = ctrl_id;
-    int res = ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
-    if (0 == res) {
-        min = queryctrl.minimum;
-        max = queryctrl.maximum;
-        //step = queryctrl.step;
-        //val_def = queryctrl.default_value;
+
+    ControlRange range;
+    if (0 == ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl)) {
+        range.min = queryctrl.minimum;
+        range.max = queryctrl.maximum;
+        range.def = queryctrl.default_value;
+        range.valid = true;
 
         if (ctrl_id == LINUX_CTRL_GAMMA) {
-            min = DEFAULT_MIN_GAMMA;
-            max = DEFAULT_MAX_GAMMA;
+            range.min = DEFAULT_MIN_GAMMA;
+            range.max = DEFAULT_MAX_GAMMA;
         }
 
+        mCtrlRanges[ctrl_id] = range;
+    }
+
+    return range;
+}
+
+void VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
+    struct v4l2_control control_s;
+    memset(&control_s, 0, sizeof (control_s));
+    int min, max;
+
+    ControlRange range = getControlRange(ctrl_id);
+    if (range.valid) {
+        min = range.min;
+        max = range.max;
     } else {
         min = 0; // queryctrl.minimum;
         max = 6500; // queryctrl.maximum;
-        //step = queryctrl.step;
-        //val_def = queryctrl.default_value;
     }
 
     if ((ctrl_val >= min) && (ctrl_val <= max)) {
@@ -1467,17 +3134,10 @@ void VideoCapture::setCameraControlSettings(int ctrl_id, int ctrl_val) {
 void VideoCapture::resetCameraControlSettings(int ctrl_id) {
 
     struct v4l2_control control_s;
-    struct v4l2_queryctrl queryctrl;
-    memset(&queryctrl, 0, sizeof (queryctrl));
     memset(&control_s, 0, sizeof (control_s));
-    int val_def;
-    // save_controls(fd);
-    queryctrl.id = ctrl_id;
-    ioctl(mFileDesc, VIDIOC_QUERYCTRL, &queryctrl);
-    val_def = queryctrl.default_value;
 
     control_s.id = ctrl_id;
-    control_s.value = val_def;
+    control_s.value = getControlRange(ctrl_id).def;
     ioctl(mFileDesc, VIDIOC_S_CTRL, &control_s);
     return;
 }
@@ -1497,18 +3157,23 @@ int VideoCapture::setGammaPreset(int side, int value)
     if (side == 1)
         ulAddr = 0x80181D00;
 
-    int hr = 0;
-
-    for (int i = 0; i < 15; i++) {
-        hr += ll_write_system_register(ulAddr, PRESET_GAMMA[value-1][i]);
-        usleep(10);
-        uint8_t valRead = 0x0;
-        hr += ll_read_system_register(ulAddr, &valRead);
-        if (valRead != PRESET_GAMMA[value-1][i]) {
-            return -3;
-        }
-        ulAddr++;
+    // ----> Gamma curve write and bulk verification
+    const std::lock_guard<std::mutex> lock(mRegMutex);
+
+    int hr = ll_write_system_registers(ulAddr, PRESET_GAMMA[value-1], 15);
+    uint8_t valRead[15] = {0};
+    hr += ll_read_system_registers(ulAddr, valRead, 15);
+    if (hr == 0 && memcmp(valRead, PRESET_GAMMA[value-1], 15) != 0 && mSystemBurst) {
+        // The firmware ignored the multi-register transfers, retry with single register transfers
+        WARNING_OUT(mParams.verbose,"Multi-register system transfers not supported by the firmware");
+        mSystemBurst = false;
+        hr = ll_write_system_registers(ulAddr, PRESET_GAMMA[value-1], 15);
+        hr += ll_read_system_registers(ulAddr, valRead, 15);
+    }
+    if (memcmp(valRead, PRESET_GAMMA[value-1], 15) != 0) {
+        return -3;
     }
+    // <---- Gamma curve write and bulk verification
 
     ulAddr = 0x80181510;
 
@@ -1516,9 +3181,9 @@ int VideoCapture::setGammaPreset(int side, int value)
         ulAddr = 0x80181D10;
     hr += ll_write_system_register(ulAddr, 0x01);
     usleep(10);
-    uint8_t valRead = 0x0;
-    hr += ll_read_system_register(ulAddr, &valRead);
-    if (valRead != 0x01)
+    uint8_t enRead = 0x0;
+    hr += ll_read_system_register(ulAddr, &enRead);
+    if (enRead != 0x01)
         return -2;
 
     return hr;
@@ -1630,26 +3295,56 @@ void VideoCapture::resetAutoWhiteBalance()
 
 void VideoCapture::setGamma(int gamma)
 {
-    int current_gamma = getCameraControlSettings(LINUX_CTRL_GAMMA);
+    writeGamma(gamma);
+}
+
+int VideoCapture::writeGamma(int gamma)
+{
+    int current_gamma = getGamma();
+
+    if (gamma==current_gamma)
+        return 0;
+
+    int hr = setGammaPreset(0,gamma);
+    hr += setGammaPreset(1,gamma);
+    setCameraControlSettings(LINUX_CTRL_GAMMA, gamma);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.gammaValid = (hr==0);
+    mCtrlCache.gamma = std::max(DEFAULT_MIN_GAMMA, std::min(gamma, DEFAULT_MAX_GAMMA));
 
-    if (gamma!=current_gamma)
-    {
-        setGammaPreset(0,gamma);
-        setGammaPreset(1,gamma);
-        setCameraControlSettings(LINUX_CTRL_GAMMA, gamma);
-    }
+    return hr;
 }
 
 void VideoCapture::resetGamma()
 {
     int def_value = DEFAULT_GAMMA_NOECT;
-    setGammaPreset(0,def_value);
-    setGammaPreset(1,def_value);
+    int hr = setGammaPreset(0,def_value);
+    hr += setGammaPreset(1,def_value);
     setCameraControlSettings(LINUX_CTRL_GAMMA, def_value);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.gammaValid = (hr==0);
+    mCtrlCache.gamma = def_value;
 }
 
 int VideoCapture::getGamma() {
-    return getCameraControlSettings(LINUX_CTRL_GAMMA);
+    mCacheMutex.lock();
+    if( mCtrlCache.gammaValid )
+    {
+        int gamma = mCtrlCache.gamma;
+        mCacheMutex.unlock();
+        return gamma;
+    }
+    mCacheMutex.unlock();
+
+    int gamma = getCameraControlSettings(LINUX_CTRL_GAMMA);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.gammaValid = (gamma>=0);
+    mCtrlCache.gamma = gamma;
+
+    return gamma;
 }
 
 int VideoCapture::setAECAGC(bool active)
@@ -1657,13 +3352,48 @@ int VideoCapture::setAECAGC(bool active)
     int res = 0;
     res += ll_isp_aecagc_enable(0, active);
     res += ll_isp_aecagc_enable(1, active);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.aecagcValid = (res==0);
+    mCtrlCache.aecagc = active;
+    if( active && mCacheRefreshMsec==0 )
+    {
+        // Gain and Exposure are now changed by the camera
+        mCtrlCache.gainValid[0] = mCtrlCache.gainValid[1] = false;
+        mCtrlCache.exposureValid[0] = mCtrlCache.exposureValid[1] = false;
+    }
+
     return res;
 }
 
 bool VideoCapture::getAECAGC()
+{
+    mCacheMutex.lock();
+    if( mCtrlCache.aecagcValid )
+    {
+        bool active = mCtrlCache.aecagc;
+        mCacheMutex.unlock();
+        return active;
+    }
+    mCacheMutex.unlock();
+
+    int res = readAECAGC();
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.aecagcValid = (res>=0);
+    mCtrlCache.aecagc = (res>0);
+
+    return (res!=0);
+}
+
+int VideoCapture::readAECAGC()
 {
     int resL = ll_isp_is_aecagc(0);
     int resR = ll_isp_is_aecagc(1);
+
+    if( resL<0 || resR<0 )
+        return -1;
+
     return (resL && resR);
 }
 
@@ -1674,8 +3404,14 @@ void VideoCapture::resetAECAGC()
 
 void VideoCapture::setGain(CAM_SENS_POS cam, int gain)
 {
+    writeGain(cam, gain);
+}
+
+int VideoCapture::writeGain(CAM_SENS_POS cam, int gain)
+{
+    int hr = 0;
     if(getAECAGC())
-        setAECAGC(false);
+        hr += setAECAGC(false);
 
     if (gain <= DEFAULT_MIN_GAIN)
         gain = DEFAULT_MIN_GAIN;
@@ -1690,11 +3426,17 @@ void VideoCapture::setGain(CAM_SENS_POS cam, int gain)
 
     ucGainM = (rawGain >> 8) & 0xff;
     ucGainL = rawGain & 0xff;
-    ll_isp_set_gain(ucGainH, ucGainM, ucGainL, sensorId);
+    int res = ll_isp_set_gain(ucGainH, ucGainM, ucGainL, sensorId);
+    hr += res;
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.gainValid[sensorId] = (res==0);
+    mCtrlCache.gain[sensorId] = calcGainValue(rawGain);
 
+    return hr;
 }
 
-int VideoCapture::getGain(CAM_SENS_POS cam)
+int VideoCapture::readGain(CAM_SENS_POS cam)
 {
     int rawGain=0;
 
@@ -1711,11 +3453,17 @@ int VideoCapture::getGain(CAM_SENS_POS cam)
 }
 
 void VideoCapture::setExposure(CAM_SENS_POS cam, int exposure)
+{
+    writeExposure(cam, exposure);
+}
+
+int VideoCapture::writeExposure(CAM_SENS_POS cam, int exposure)
 {
     unsigned char ucExpH, ucExpM, ucExpL;
 
+    int hr = 0;
     if(getAECAGC())
-        setAECAGC(false);
+        hr += setAECAGC(false);
 
     if(exposure < DEFAULT_MIN_EXP)
         exposure = DEFAULT_MIN_EXP;
@@ -1726,17 +3474,84 @@ void VideoCapture::setExposure(CAM_SENS_POS cam, int exposure)
     if(rawExp<EXP_RAW_MIN)
         rawExp = EXP_RAW_MIN;
 
-    std::cout << "Set Raw Exp: " << rawExp << std::endl;
-
     int sensorId = static_cast<int>(cam);
 
     ucExpH = (rawExp >> 12) & 0xff;
     ucExpM = (rawExp >> 4) & 0xff;
     ucExpL = (rawExp << 4) & 0xf0;
-    ll_isp_set_exposure(ucExpH, ucExpM, ucExpL, sensorId);
+    int res = ll_isp_set_exposure(ucExpH, ucExpM, ucExpL, sensorId);
+    hr += res;
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.exposureValid[sensorId] = (res==0);
+    mCtrlCache.exposure[sensorId] = static_cast<int>(std::round((100.0*rawExp)/mExpoureRawMax));
+
+    return hr;
 }
 
-int VideoCapture::getExposure(CAM_SENS_POS cam)
+int VideoCapture::setStereoGain(int gain)
+{
+    if(getAECAGC())
+        setAECAGC(false);
+
+    if (gain <= DEFAULT_MIN_GAIN)
+        gain = DEFAULT_MIN_GAIN;
+    else if (gain >= DEFAULT_MAX_GAIN)
+        gain = DEFAULT_MAX_GAIN;
+
+    int rawGain = calcRawGainValue(gain);
+
+    std::vector<SensorRegBlock> blocks(2);
+    for(int side = 0; side < 2; side++)
+    {
+        blocks[side].side = side;
+        blocks[side].address = ADD_GAIN_H;
+        blocks[side].values = {0, static_cast<uint8_t>((rawGain >> 8) & 0xff), static_cast<uint8_t>(rawGain & 0xff)};
+    }
+
+    int hr = ll_sensor_transaction(blocks, true);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.gainValid[0] = mCtrlCache.gainValid[1] = (hr==0);
+    mCtrlCache.gain[0] = mCtrlCache.gain[1] = calcGainValue(rawGain);
+
+    return hr;
+}
+
+int VideoCapture::setStereoExposure(int exposure)
+{
+    if(getAECAGC())
+        setAECAGC(false);
+
+    if(exposure < DEFAULT_MIN_EXP)
+        exposure = DEFAULT_MIN_EXP;
+    if(exposure > DEFAULT_MAX_EXP)
+        exposure = DEFAULT_MAX_EXP;
+
+    int rawExp = (mExpoureRawMax * ((float) exposure / 100.0));
+    if(rawExp<EXP_RAW_MIN)
+        rawExp = EXP_RAW_MIN;
+
+    std::vector<SensorRegBlock> blocks(2);
+    for(int side = 0; side < 2; side++)
+    {
+        blocks[side].side = side;
+        blocks[side].address = ADD_EXP_H;
+        blocks[side].values = {static_cast<uint8_t>((rawExp >> 12) & 0xff),
+                               static_cast<uint8_t>((rawExp >> 4) & 0xff),
+                               static_cast<uint8_t>((rawExp << 4) & 0xf0)};
+    }
+
+    int hr = ll_sensor_transaction(blocks, true);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.exposureValid[0] = mCtrlCache.exposureValid[1] = (hr==0);
+    mCtrlCache.exposure[0] = mCtrlCache.exposure[1] = static_cast<int>(std::round((100.0*rawExp)/mExpoureRawMax));
+
+    return hr;
+}
+
+int VideoCapture::readExposure(CAM_SENS_POS cam)
 {
     int rawExp=0;
 
@@ -1750,12 +3565,470 @@ int VideoCapture::getExposure(CAM_SENS_POS cam)
         return r;
     rawExp = (int) ((val[2] << 12) + (val[1] << 4) + (val[0] >> 4));
 
-    std::cout << "Get Raw Exp: " << rawExp << std::endl;
-
     int exposure = static_cast<int>(std::round((100.0*rawExp)/mExpoureRawMax));
     return exposure;
 }
 
+// ----> Control cache
+int VideoCapture::getGain(CAM_SENS_POS cam)
+{
+    int sensorId = static_cast<int>(cam);
+
+    mCacheMutex.lock();
+    // With the automatic control active the cache is coherent only if refreshed
+    bool cacheable = mCtrlCache.aecagcValid && (!mCtrlCache.aecagc || mCacheRefreshMsec>0);
+    if( cacheable && mCtrlCache.gainValid[sensorId] )
+    {
+        int gain = mCtrlCache.gain[sensorId];
+        mCacheMutex.unlock();
+        return gain;
+    }
+    mCacheMutex.unlock();
+
+    int gain = readGain(cam);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.gainValid[sensorId] = (gain>=0);
+    mCtrlCache.gain[sensorId] = gain;
+
+    return gain;
+}
+
+int VideoCapture::getExposure(CAM_SENS_POS cam)
+{
+    int sensorId = static_cast<int>(cam);
+
+    mCacheMutex.lock();
+    // With the automatic control active the cache is coherent only if refreshed
+    bool cacheable = mCtrlCache.aecagcValid && (!mCtrlCache.aecagc || mCacheRefreshMsec>0);
+    if( cacheable && mCtrlCache.exposureValid[sensorId] )
+    {
+        int exposure = mCtrlCache.exposure[sensorId];
+        mCacheMutex.unlock();
+        return exposure;
+    }
+    mCacheMutex.unlock();
+
+    int exposure = readExposure(cam);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache.exposureValid[sensorId] = (exposure>=0);
+    mCtrlCache.exposure[sensorId] = exposure;
+
+    return exposure;
+}
+
+void VideoCapture::invalidateControlCache()
+{
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache = ControlCache();
+}
+
+void VideoCapture::setControlCacheRefresh(uint64_t period_msec)
+{
+    std::unique_lock<std::mutex> lock(mControlMutex);
+    mCacheRefreshMsec = period_msec;
+    if( period_msec>0 )
+    {
+        startControlThreadLocked();
+    }
+    lock.unlock();
+
+    mControlCond.notify_one();
+}
+
+void VideoCapture::refreshControlCache()
+{
+    if( !mInitialized )
+        return;
+
+    ControlCache cache;
+
+    int aecagc = readAECAGC();
+    cache.aecagcValid = (aecagc>=0);
+    cache.aecagc = (aecagc>0);
+
+    for( int side = 0; side < 2; side++ )
+    {
+        cache.gain[side] = readGain(static_cast<CAM_SENS_POS>(side));
+        cache.gainValid[side] = (cache.gain[side]>=0);
+        cache.exposure[side] = readExposure(static_cast<CAM_SENS_POS>(side));
+        cache.exposureValid[side] = (cache.exposure[side]>=0);
+    }
+
+    cache.gamma = getCameraControlSettings(LINUX_CTRL_GAMMA);
+    cache.gammaValid = (cache.gamma>=0);
+
+    uint8_t val = 0;
+    int hr = ll_set_gpio_direction(2, 1);
+    hr += ll_get_gpio_value(2, &val);
+    cache.ledValid = (hr==0);
+    cache.led = (val!=0);
+
+    const std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCtrlCache = cache;
+}
+// <---- Control cache
+
+// ----> Camera settings profile
+std::string CameraSettingsProfile::toString() const
+{
+    std::stringstream ss;
+    ss << "brightness=" << brightness << std::endl;
+    ss << "contrast=" << contrast << std::endl;
+    ss << "hue=" << hue << std::endl;
+    ss << "saturation=" << saturation << std::endl;
+    ss << "sharpness=" << sharpness << std::endl;
+    ss << "gamma=" << gamma << std::endl;
+    ss << "white_balance=" << white_balance << std::endl;
+    ss << "auto_white_balance=" << (auto_white_balance?1:0) << std::endl;
+    ss << "aec_agc=" << (aec_agc?1:0) << std::endl;
+
+    return ss.str();
+}
+
+bool CameraSettingsProfile::fromString(const std::string& str)
+{
+    std::istringstream ss(str);
+    std::string line;
+
+    while( std::getline(ss,line) )
+    {
+        if( line.empty() )
+            continue;
+
+        size_t sep = line.find('=');
+        if( sep==std::string::npos )
+            return false;
+
+        std::string key = line.substr(0,sep);
+        int value = 0;
+        std::istringstream valStream(line.substr(sep+1));
+        if( !(valStream >> value) )
+            return false;
+
+        if( key=="brightness" ) brightness = value;
+        else if( key=="contrast" ) contrast = value;
+        else if( key=="hue" ) hue = value;
+        else if( key=="saturation" ) saturation = value;
+        else if( key=="sharpness" ) sharpness = value;
+        else if( key=="gamma" ) gamma = value;
+        else if( key=="white_balance" ) white_balance = value;
+        else if( key=="auto_white_balance" ) auto_white_balance = (value!=0);
+        else if( key=="aec_agc" ) aec_agc = (value!=0);
+    }
+
+    return true;
+}
+
+CameraSettingsProfile VideoCapture::getDefaultSettingsProfile()
+{
+    CameraSettingsProfile profile;
+    profile.brightness = getControlRange(LINUX_CTRL_BRIGHTNESS).def;
+    profile.contrast = getControlRange(LINUX_CTRL_CONTRAST).def;
+    profile.hue = getControlRange(LINUX_CTRL_HUE).def;
+    profile.saturation = getControlRange(LINUX_CTRL_SATURATION).def;
+    profile.sharpness = getControlRange(LINUX_CTRL_SHARPNESS).def;
+    profile.white_balance = getControlRange(LINUX_CTRL_AWB).def;
+    profile.gamma = DEFAULT_GAMMA_NOECT;
+    profile.auto_white_balance = true;
+    profile.aec_agc = true;
+
+    return profile;
+}
+
+CameraSettingsProfile VideoCapture::getSettingsProfile()
+{
+    CameraSettingsProfile profile;
+
+    struct v4l2_ext_control ctrls[8];
+    memset(ctrls, 0, sizeof (ctrls));
+    ctrls[0].id = LINUX_CTRL_BRIGHTNESS;
+    ctrls[1].id = LINUX_CTRL_CONTRAST;
+    ctrls[2].id = LINUX_CTRL_HUE;
+    ctrls[3].id = LINUX_CTRL_SATURATION;
+    ctrls[4].id = LINUX_CTRL_SHARPNESS;
+    ctrls[5].id = LINUX_CTRL_AWB;
+    ctrls[6].id = LINUX_CTRL_AWB_AUTO;
+    ctrls[7].id = LINUX_CTRL_GAMMA;
+
+    struct v4l2_ext_controls ext;
+    memset(&ext, 0, sizeof (ext));
+    ext.ctrl_class = V4L2_CTRL_CLASS_USER;
+    ext.count = 8;
+    ext.controls = ctrls;
+
+    if (0 == ioctl(mFileDesc, VIDIOC_G_EXT_CTRLS, &ext))
+    {
+        profile.brightness = ctrls[0].value;
+        profile.contrast = ctrls[1].value;
+        profile.hue = ctrls[2].value;
+        profile.saturation = ctrls[3].value;
+        profile.sharpness = ctrls[4].value;
+        profile.white_balance = ctrls[5].value;
+        profile.auto_white_balance = (ctrls[6].value!=0);
+        profile.gamma = ctrls[7].value;
+    }
+    else
+    {
+        profile.brightness = getBrightness();
+        profile.contrast = getContrast();
+        profile.hue = getHue();
+        profile.saturation = getSaturation();
+        profile.sharpness = getSharpness();
+        profile.white_balance = getWhiteBalance();
+        profile.auto_white_balance = getAutoWhiteBalance();
+        profile.gamma = getCameraControlSettings(LINUX_CTRL_GAMMA);
+    }
+
+    profile.aec_agc = getAECAGC();
+
+    return profile;
+}
+
+int VideoCapture::applySettingsProfile(const CameraSettingsProfile& profile)
+{
+    if (!mInitialized)
+        return -1;
+
+    int gamma = std::max(DEFAULT_MIN_GAMMA, std::min(profile.gamma, DEFAULT_MAX_GAMMA));
+
+    // ----> UVC controls
+    struct v4l2_ext_control ctrls[8];
+    memset(ctrls, 0, sizeof (ctrls));
+    unsigned int count = 0;
+
+    auto addCtrl = [&](int ctrl_id, int value) {
+        ControlRange range = getControlRange(ctrl_id);
+        if (!range.valid)
+            return;
+        ctrls[count].id = ctrl_id;
+        ctrls[count].value = std::max(range.min, std::min(value, range.max));
+        count++;
+    };
+
+    addCtrl(LINUX_CTRL_BRIGHTNESS, profile.brightness);
+    addCtrl(LINUX_CTRL_CONTRAST, profile.contrast);
+    addCtrl(LINUX_CTRL_HUE, profile.hue);
+    addCtrl(LINUX_CTRL_SATURATION, profile.saturation);
+    addCtrl(LINUX_CTRL_SHARPNESS, profile.sharpness);
+    addCtrl(LINUX_CTRL_GAMMA, gamma);
+    // The automatic White Balance must be disabled before setting the temperature
+    addCtrl(LINUX_CTRL_AWB_AUTO, profile.auto_white_balance?1:0);
+    if (!profile.auto_white_balance)
+        addCtrl(LINUX_CTRL_AWB, profile.white_balance);
+
+    struct v4l2_ext_controls ext;
+    memset(&ext, 0, sizeof (ext));
+    ext.ctrl_class = V4L2_CTRL_CLASS_USER;
+    ext.count = count;
+    ext.controls = ctrls;
+
+    int res = 0;
+    if (0 != ioctl(mFileDesc, VIDIOC_S_EXT_CTRLS, &ext))
+    {
+        WARNING_OUT(mParams.verbose,"Cannot apply the camera settings with a single call, setting them one by one");
+
+        for (unsigned int i = 0; i < count; i++)
+            setCameraControlSettings(ctrls[i].id, ctrls[i].value);
+    }
+    // <---- UVC controls
+
+    // ----> ISP settings, written only if not already set by the library
+    mCacheMutex.lock();
+    bool gammaSet = mCtrlCache.gammaValid && mCtrlCache.gamma==gamma;
+    bool aecagcSet = mCtrlCache.aecagcValid && mCtrlCache.aecagc==profile.aec_agc;
+    mCacheMutex.unlock();
+
+    if (!gammaSet)
+    {
+        int hr = setGammaPreset(0,gamma);
+        hr += setGammaPreset(1,gamma);
+        res += hr;
+
+        const std::lock_guard<std::mutex> lock(mCacheMutex);
+        mCtrlCache.gammaValid = (hr==0);
+        mCtrlCache.gamma = gamma;
+    }
+
+    if (!aecagcSet)
+    {
+        res += setAECAGC(profile.aec_agc);
+    }
+    // <---- ISP settings, written only if not already set by the library
+
+    return res;
+}
+// <---- Camera settings profile
+
+// ----> Asynchronous Camera Settings control
+// Keys used to coalesce the commands setting the same control
+static const uint32_t CTRL_KEY_EXPOSURE = 0x0100;
+static const uint32_t CTRL_KEY_GAIN = 0x0200;
+static const uint32_t CTRL_KEY_GAMMA = 0x0300;
+static const uint32_t CTRL_KEY_AECAGC = 0x0400;
+static const uint32_t CTRL_KEY_LED = 0x0500;
+
+std::future<int> VideoCapture::setExposureAsync(CAM_SENS_POS cam, int exposure)
+{
+    return submitControl( CTRL_KEY_EXPOSURE|static_cast<uint32_t>(cam), [this,cam,exposure]() {
+        return writeExposure(cam,exposure);
+    });
+}
+
+std::future<int> VideoCapture::setGainAsync(CAM_SENS_POS cam, int gain)
+{
+    return submitControl( CTRL_KEY_GAIN|static_cast<uint32_t>(cam), [this,cam,gain]() {
+        return writeGain(cam,gain);
+    });
+}
+
+std::future<int> VideoCapture::setGammaAsync(int gamma)
+{
+    return submitControl( CTRL_KEY_GAMMA, [this,gamma]() {
+        return writeGamma(gamma);
+    });
+}
+
+std::future<int> VideoCapture::setAECAGCAsync(bool active)
+{
+    return submitControl( CTRL_KEY_AECAGC, [this,active]() {
+        return setAECAGC(active);
+    });
+}
+
+std::future<int> VideoCapture::setLEDstatusAsync(bool status)
+{
+    return submitControl( CTRL_KEY_LED, [this,status]() {
+        return setLEDstatus(status);
+    });
+}
+
+std::future<int> VideoCapture::submitControl(uint32_t key, std::function<int()> action)
+{
+    std::promise<int> promise;
+    std::future<int> future = promise.get_future();
+
+    ControlCommand cmd;
+    cmd.key = key;
+    cmd.action = action;
+
+    std::unique_lock<std::mutex> lock(mControlMutex);
+
+    if( mControlStop )
+    {
+        promise.set_value(-1);
+        return future;
+    }
+
+    startControlThreadLocked();
+
+    // ----> Coalesce with a pending command setting the same control
+    // The new command is moved to the end of the queue to keep the order of the writes
+    for( std::deque<ControlCommand>::iterator it = mControlQueue.begin(); it != mControlQueue.end(); ++it )
+    {
+        if( it->key == key )
+        {
+            cmd.promises = std::move(it->promises);
+            mControlQueue.erase(it);
+            break;
+        }
+    }
+    // <---- Coalesce with a pending command setting the same control
+
+    cmd.promises.push_back(std::move(promise));
+    mControlQueue.push_back(std::move(cmd));
+    lock.unlock();
+
+    mControlCond.notify_one();
+
+    return future;
+}
+
+void VideoCapture::startControlThreadLocked()
+{
+    if( !mControlThread.joinable() && !mControlStop )
+    {
+        mControlThread = std::thread( &VideoCapture::controlThreadFunc, this );
+    }
+}
+
+void VideoCapture::controlThreadFunc()
+{
+    std::unique_lock<std::mutex> lock(mControlMutex);
+    std::chrono::steady_clock::time_point nextRefresh = std::chrono::steady_clock::now();
+
+    while( true )
+    {
+        auto ready = [this]{ return mControlStop || !mControlQueue.empty(); };
+
+        if( mCacheRefreshMsec>0 )
+        {
+            if( !mControlCond.wait_until( lock, nextRefresh, ready ) )
+            {
+                // ----> Control cache refresh
+                nextRefresh = std::chrono::steady_clock::now() + std::chrono::milliseconds(mCacheRefreshMsec);
+                lock.unlock();
+                refreshControlCache();
+                lock.lock();
+                // <---- Control cache refresh
+                continue;
+            }
+        }
+        else
+        {
+            mControlCond.wait( lock, ready );
+        }
+
+        if( mControlStop )
+            break;
+
+        ControlCommand cmd = std::move(mControlQueue.front());
+        mControlQueue.pop_front();
+        lock.unlock();
+
+        int res = cmd.action();
+        for( auto& promise : cmd.promises )
+            promise.set_value(res);
+
+        lock.lock();
+    }
+
+    // ----> The pending commands are not executed
+    for( auto& cmd : mControlQueue )
+    {
+        for( auto& promise : cmd.promises )
+            promise.set_value(-1);
+    }
+    mControlQueue.clear();
+    // <---- The pending commands are not executed
+}
+
+void VideoCapture::resumeControlThread()
+{
+    const std::lock_guard<std::mutex> lock(mControlMutex);
+    mControlStop = false;
+    if( mCacheRefreshMsec>0 )
+    {
+        startControlThreadLocked();
+    }
+}
+
+void VideoCapture::stopControlThread()
+{
+    mControlMutex.lock();
+    mControlStop = true;
+    mControlMutex.unlock();
+
+    mControlCond.notify_all();
+
+    if( mControlThread.joinable() )
+    {
+        mControlThread.join();
+    }
+}
+// <---- Asynchronous Camera Settings control
+
 int VideoCapture::calcRawGainValue(int gain) {
 
     // From [0,100] to segmented gain